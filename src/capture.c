@@ -0,0 +1,372 @@
+#include <vlc_common.h>
+#include <vlc_input.h>
+#include <vlc_interface.h>
+#include <vlc_mouse.h>
+#if LIBVLC_VERSION_MAJOR >= 4
+#include <vlc_player.h>
+#endif
+#include <vlc_playlist.h>
+#include <vlc_variables.h>
+#include <vlc_vout.h>
+
+#include "capture.h"
+#include "compat.h"
+
+#define CAPTURE_MAX_VOUTS 4
+
+struct capture_t
+{
+    intf_thread_t *p_intf;
+    capture_callback_t callback;
+    capture_vouts_callback_t vouts_callback;
+    void *opaque;
+
+    // serializes the callback, and protects the mouse state and video size
+    vlc_mutex_t mouse_lock;
+    vlc_mouse_t mouse;
+    unsigned width;
+    unsigned height;
+
+    // Video outputs whose variables are watched, held. Only changed with
+    // vouts_lock held, the player (VLC 4) or input (VLC 3) event callbacks
+    // being the writers.
+    vlc_mutex_t vouts_lock;
+    vout_thread_t *vouts[CAPTURE_MAX_VOUTS];
+    size_t vout_count;
+
+#if LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t *player;
+    vlc_player_listener_id *listener;
+#else
+    playlist_t *p_playlist;
+    input_thread_t *p_input; // held, protected by vouts_lock
+#endif
+};
+
+static void capture_vout_hold(vout_thread_t *p_vout)
+{
+#if LIBVLC_VERSION_MAJOR >= 4
+    vout_Hold(p_vout);
+#else
+    vlc_object_hold(p_vout);
+#endif
+}
+
+static void capture_vout_release(vout_thread_t *p_vout)
+{
+#if LIBVLC_VERSION_MAJOR >= 4
+    vout_Release(p_vout);
+#else
+    vlc_object_release((vlc_object_t *)p_vout);
+#endif
+}
+
+static void capture_set_size(capture_t *p_capture, const es_format_t *p_fmt)
+{
+    vlc_mutex_lock(&p_capture->mouse_lock);
+    p_capture->width = p_fmt->video.i_visible_width ? p_fmt->video.i_visible_width : p_fmt->video.i_width;
+    p_capture->height = p_fmt->video.i_visible_height ? p_fmt->video.i_visible_height : p_fmt->video.i_height;
+    vlc_mutex_unlock(&p_capture->mouse_lock);
+}
+
+static int capture_button_callback(vlc_object_t *p_this, const char *name,
+                                   vlc_value_t oldval, vlc_value_t newval, void *data)
+{
+    VLC_UNUSED(p_this); VLC_UNUSED(name); VLC_UNUSED(oldval);
+    capture_t *p_capture = data;
+
+    vlc_mutex_lock(&p_capture->mouse_lock);
+    vlc_mouse_t old = p_capture->mouse;
+    p_capture->mouse.i_pressed = newval.i_int;
+    if (p_capture->mouse.i_pressed != old.i_pressed)
+        p_capture->callback(p_capture->opaque, &old, &p_capture->mouse, p_capture->width, p_capture->height);
+    vlc_mutex_unlock(&p_capture->mouse_lock);
+
+    return VLC_SUCCESS;
+}
+
+static int capture_moved_callback(vlc_object_t *p_this, const char *name,
+                                  vlc_value_t oldval, vlc_value_t newval, void *data)
+{
+    VLC_UNUSED(p_this); VLC_UNUSED(name); VLC_UNUSED(oldval);
+    capture_t *p_capture = data;
+
+    vlc_mutex_lock(&p_capture->mouse_lock);
+    vlc_mouse_t old = p_capture->mouse;
+    p_capture->mouse.i_x = newval.coords.x;
+    p_capture->mouse.i_y = newval.coords.y;
+    p_capture->callback(p_capture->opaque, &old, &p_capture->mouse, p_capture->width, p_capture->height);
+    vlc_mutex_unlock(&p_capture->mouse_lock);
+
+    return VLC_SUCCESS;
+}
+
+// Takes over the reference, with vouts_lock held
+static void capture_add_vout(capture_t *p_capture, vout_thread_t *p_vout)
+{
+    if (p_capture->vout_count == CAPTURE_MAX_VOUTS) {
+        capture_vout_release(p_vout);
+        return;
+    }
+
+    p_capture->vouts[p_capture->vout_count++] = p_vout;
+    var_AddCallback(p_vout, "mouse-button-down", capture_button_callback, p_capture);
+    var_AddCallback(p_vout, "mouse-moved", capture_moved_callback, p_capture);
+    p_capture->vouts_callback(p_capture->opaque);
+}
+
+// With vouts_lock held. Removing a callback waits for it to return, which
+// only takes mouse_lock.
+static void capture_remove_vout(capture_t *p_capture, size_t index)
+{
+    vout_thread_t *p_vout = p_capture->vouts[index];
+
+    var_DelCallback(p_vout, "mouse-button-down", capture_button_callback, p_capture);
+    var_DelCallback(p_vout, "mouse-moved", capture_moved_callback, p_capture);
+    capture_vout_release(p_vout);
+    p_capture->vouts[index] = p_capture->vouts[--p_capture->vout_count];
+    p_capture->vouts_callback(p_capture->opaque);
+
+    // The release won't be reported anymore, a button still down would
+    // otherwise keep a hold running
+    vlc_mutex_lock(&p_capture->mouse_lock);
+    vlc_mouse_t old = p_capture->mouse;
+    vlc_mouse_Init(&p_capture->mouse);
+    if (old.i_pressed)
+        p_capture->callback(p_capture->opaque, &old, &p_capture->mouse, p_capture->width, p_capture->height);
+    vlc_mutex_unlock(&p_capture->mouse_lock);
+}
+
+static bool capture_has_vout(const capture_t *p_capture, vout_thread_t *p_vout)
+{
+    for (size_t i = 0; i < p_capture->vout_count; i++) {
+        if (p_capture->vouts[i] == p_vout)
+            return true;
+    }
+    return false;
+}
+
+#if LIBVLC_VERSION_MAJOR >= 4
+
+static void capture_track_size(capture_t *p_capture, vlc_es_id_t *es_id)
+{
+    const struct vlc_player_track *p_track = es_id ? vlc_player_GetTrack(p_capture->player, es_id)
+                                                   : vlc_player_GetSelectedTrack(p_capture->player, VIDEO_ES);
+    if (p_track)
+        capture_set_size(p_capture, &p_track->fmt);
+}
+
+// Called with the player lock held
+static void capture_on_vout_changed(vlc_player_t *player, enum vlc_player_vout_action action,
+                                    vout_thread_t *p_vout, enum vlc_vout_order order,
+                                    vlc_es_id_t *es_id, void *data)
+{
+    VLC_UNUSED(player); VLC_UNUSED(order);
+    capture_t *p_capture = data;
+
+    vlc_mutex_lock(&p_capture->vouts_lock);
+    if (action == VLC_PLAYER_VOUT_STARTED) {
+        if (!capture_has_vout(p_capture, p_vout)) {
+            capture_vout_hold(p_vout);
+            capture_add_vout(p_capture, p_vout);
+        }
+        capture_track_size(p_capture, es_id);
+    } else {
+        for (size_t i = 0; i < p_capture->vout_count; i++) {
+            if (p_capture->vouts[i] == p_vout) {
+                capture_remove_vout(p_capture, i);
+                break;
+            }
+        }
+    }
+    vlc_mutex_unlock(&p_capture->vouts_lock);
+}
+
+static int capture_follow(capture_t *p_capture)
+{
+    static const struct vlc_player_cbs cbs = {
+        .on_vout_changed = capture_on_vout_changed,
+    };
+
+    p_capture->player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_capture->p_intf));
+
+    vlc_player_Lock(p_capture->player);
+    p_capture->listener = vlc_player_AddListener(p_capture->player, &cbs, p_capture);
+    if (p_capture->listener) {
+        // the video outputs started before the listener
+        size_t count;
+        vout_thread_t **pp_vouts = vlc_player_vout_HoldAll(p_capture->player, &count);
+        vlc_mutex_lock(&p_capture->vouts_lock);
+        for (size_t i = 0; pp_vouts && i < count; i++)
+            capture_add_vout(p_capture, pp_vouts[i]);
+        if (count > 0)
+            capture_track_size(p_capture, NULL);
+        vlc_mutex_unlock(&p_capture->vouts_lock);
+        free(pp_vouts);
+    }
+    vlc_player_Unlock(p_capture->player);
+
+    return p_capture->listener ? VLC_SUCCESS : VLC_ENOMEM;
+}
+
+static void capture_unfollow(capture_t *p_capture)
+{
+    vlc_player_Lock(p_capture->player);
+    vlc_player_RemoveListener(p_capture->player, p_capture->listener);
+    vlc_player_Unlock(p_capture->player);
+
+    vlc_mutex_lock(&p_capture->vouts_lock);
+    while (p_capture->vout_count > 0)
+        capture_remove_vout(p_capture, 0);
+    vlc_mutex_unlock(&p_capture->vouts_lock);
+}
+
+#else
+
+// Matches the watched video outputs with those of the input, with vouts_lock
+// held
+static void capture_sync_vouts(capture_t *p_capture, input_thread_t *p_input)
+{
+    vout_thread_t **pp_vouts = NULL;
+    size_t count = 0;
+
+    if (p_input && input_Control(p_input, INPUT_GET_VOUTS, &pp_vouts, &count) != VLC_SUCCESS) {
+        pp_vouts = NULL;
+        count = 0;
+    }
+
+    for (size_t i = p_capture->vout_count; i-- > 0;) {
+        bool found = false;
+        for (size_t j = 0; j < count && !found; j++)
+            found = pp_vouts[j] == p_capture->vouts[i];
+        if (!found)
+            capture_remove_vout(p_capture, i);
+    }
+
+    for (size_t j = 0; j < count; j++) {
+        if (capture_has_vout(p_capture, pp_vouts[j]))
+            capture_vout_release(pp_vouts[j]);
+        else
+            capture_add_vout(p_capture, pp_vouts[j]);
+    }
+    free(pp_vouts);
+
+    if (!p_input || count == 0)
+        return;
+
+    input_item_t *p_item = input_GetItem(p_input);
+    vlc_mutex_lock(&p_item->lock);
+    for (int i = 0; i < p_item->i_es; i++) {
+        if (p_item->es[i]->i_cat == VIDEO_ES) {
+            capture_set_size(p_capture, p_item->es[i]);
+            break;
+        }
+    }
+    vlc_mutex_unlock(&p_item->lock);
+}
+
+static int capture_input_event(vlc_object_t *p_this, const char *name,
+                               vlc_value_t oldval, vlc_value_t newval, void *data)
+{
+    VLC_UNUSED(name); VLC_UNUSED(oldval);
+    capture_t *p_capture = data;
+
+    if (newval.i_int != INPUT_EVENT_VOUT)
+        return VLC_SUCCESS;
+
+    vlc_mutex_lock(&p_capture->vouts_lock);
+    // events of the previous input still being delivered
+    if ((vlc_object_t *)p_capture->p_input == p_this)
+        capture_sync_vouts(p_capture, p_capture->p_input);
+    vlc_mutex_unlock(&p_capture->vouts_lock);
+
+    return VLC_SUCCESS;
+}
+
+static void capture_set_input(capture_t *p_capture, input_thread_t *p_input)
+{
+    if (p_input)
+        vlc_object_hold(p_input);
+
+    vlc_mutex_lock(&p_capture->vouts_lock);
+    input_thread_t *p_old = p_capture->p_input;
+    p_capture->p_input = p_input;
+    vlc_mutex_unlock(&p_capture->vouts_lock);
+
+    // outside of vouts_lock, which the event callback takes
+    if (p_old) {
+        var_DelCallback(p_old, "intf-event", capture_input_event, p_capture);
+        vlc_object_release(p_old);
+    }
+    if (p_input)
+        var_AddCallback(p_input, "intf-event", capture_input_event, p_capture);
+
+    vlc_mutex_lock(&p_capture->vouts_lock);
+    if (p_capture->p_input == p_input)
+        capture_sync_vouts(p_capture, p_input);
+    vlc_mutex_unlock(&p_capture->vouts_lock);
+}
+
+static int capture_input_current(vlc_object_t *p_this, const char *name,
+                                 vlc_value_t oldval, vlc_value_t newval, void *data)
+{
+    VLC_UNUSED(p_this); VLC_UNUSED(name); VLC_UNUSED(oldval);
+    capture_set_input(data, newval.p_address);
+    return VLC_SUCCESS;
+}
+
+static int capture_follow(capture_t *p_capture)
+{
+    p_capture->p_playlist = pl_Get(p_capture->p_intf);
+    var_AddCallback(p_capture->p_playlist, "input-current", capture_input_current, p_capture);
+
+    input_thread_t *p_input = playlist_CurrentInput(p_capture->p_playlist);
+    if (p_input) {
+        capture_set_input(p_capture, p_input);
+        vlc_object_release(p_input);
+    }
+
+    return VLC_SUCCESS;
+}
+
+static void capture_unfollow(capture_t *p_capture)
+{
+    var_DelCallback(p_capture->p_playlist, "input-current", capture_input_current, p_capture);
+    capture_set_input(p_capture, NULL);
+}
+
+#endif
+
+capture_t *capture_start(intf_thread_t *p_intf_thread, capture_callback_t callback,
+                         capture_vouts_callback_t vouts_callback, void *opaque)
+{
+    capture_t *p_capture = calloc(1, sizeof(capture_t));
+    if (!p_capture)
+        return NULL;
+
+    p_capture->p_intf = p_intf_thread;
+    p_capture->callback = callback;
+    p_capture->vouts_callback = vouts_callback;
+    p_capture->opaque = opaque;
+    vlc_mutex_init(&p_capture->mouse_lock);
+    vlc_mutex_init(&p_capture->vouts_lock);
+    vlc_mouse_Init(&p_capture->mouse);
+
+    if (capture_follow(p_capture) != VLC_SUCCESS) {
+        _vlc_mutex_destroy(&p_capture->vouts_lock);
+        _vlc_mutex_destroy(&p_capture->mouse_lock);
+        free(p_capture);
+        return NULL;
+    }
+
+    return p_capture;
+}
+
+void capture_stop(capture_t *p_capture)
+{
+    capture_unfollow(p_capture);
+
+    _vlc_mutex_destroy(&p_capture->vouts_lock);
+    _vlc_mutex_destroy(&p_capture->mouse_lock);
+    free(p_capture);
+}
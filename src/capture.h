@@ -0,0 +1,28 @@
+#ifndef VLC_SPEED_HOLD_CAPTURE_H
+#define VLC_SPEED_HOLD_CAPTURE_H
+
+#include <vlc_common.h>
+#include <vlc_interface.h>
+#include <vlc_mouse.h>
+
+// Follows the video outputs of the player and reports the mouse events they
+// publish through their "mouse-button-down" and "mouse-moved" variables, so
+// that holds work without the video filter in the picture path.
+//
+// The callback is never called concurrently, even with several video
+// outputs. width and height are the size of the video the coordinates refer
+// to, 0 when unknown.
+typedef void (*capture_callback_t)(void *opaque, const vlc_mouse_t *p_old, const vlc_mouse_t *p_new,
+                                   unsigned width, unsigned height);
+// Called when a video output is added to or removed from the followed ones,
+// possibly with the player lock held
+typedef void (*capture_vouts_callback_t)(void *opaque);
+
+typedef struct capture_t capture_t;
+
+capture_t *capture_start(intf_thread_t *p_intf_thread, capture_callback_t callback,
+                         capture_vouts_callback_t vouts_callback, void *opaque);
+// No callback is running or will be called once this returns
+void capture_stop(capture_t *p_capture);
+
+#endif // VLC_SPEED_HOLD_CAPTURE_H
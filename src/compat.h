@@ -0,0 +1,47 @@
+#ifndef VLC_SPEED_HOLD_COMPAT_H
+#define VLC_SPEED_HOLD_COMPAT_H
+
+#include <vlc_common.h>
+#include <vlc_threads.h>
+
+// VLC 4.0 replaced mtime_t/mdate() with vlc_tick_t/vlc_tick_now(), both are
+// in microseconds
+#if LIBVLC_VERSION_MAJOR >= 4
+typedef vlc_tick_t _vlc_tick_t;
+# define _vlc_tick_now() vlc_tick_now()
+#else
+typedef mtime_t _vlc_tick_t;
+# define _vlc_tick_now() mdate()
+#endif
+
+// VLC 4.0 removed the priority argument of vlc_clone() and made mutexes,
+// condition variables and semaphores trivially destructible
+#if LIBVLC_VERSION_MAJOR >= 4
+# define _vlc_clone(th, entry, data) \
+    vlc_clone(th, entry, data)
+# define _vlc_mutex_destroy(m) ((void)(m))
+# define _vlc_cond_destroy(c) ((void)(c))
+# define _vlc_sem_destroy(s) ((void)(s))
+#else
+# define _vlc_clone(th, entry, data) \
+    vlc_clone(th, entry, data, VLC_THREAD_PRIORITY_LOW)
+# define _vlc_mutex_destroy vlc_mutex_destroy
+# define _vlc_cond_destroy vlc_cond_destroy
+# define _vlc_sem_destroy vlc_sem_destroy
+#endif
+
+// VLC 4.0 replaced the libvlc member of the objects with a getter, and
+// dropped the object argument of the configuration getters
+#if LIBVLC_VERSION_MAJOR >= 4
+# define _vlc_object_instance(o) VLC_OBJECT(vlc_object_instance(o))
+# define _config_GetInt(o, name) ((void)(o), config_GetInt(name))
+# define _config_GetFloat(o, name) ((void)(o), config_GetFloat(name))
+# define _config_GetPsz(o, name) ((void)(o), config_GetPsz(name))
+#else
+# define _vlc_object_instance(o) VLC_OBJECT(VLC_OBJECT(o)->obj.libvlc)
+# define _config_GetInt(o, name) config_GetInt(VLC_OBJECT(o), name)
+# define _config_GetFloat(o, name) config_GetFloat(VLC_OBJECT(o), name)
+# define _config_GetPsz(o, name) config_GetPsz(VLC_OBJECT(o), name)
+#endif
+
+#endif // VLC_SPEED_HOLD_COMPAT_H
@@ -6,9 +6,18 @@
 #define MOUSE_BUTTON_CFG CFG_PREFIX "mouse-button"
 #define MOUSE_BUTTON_DEFAULT 1 // MOUSE_BUTTON_LEFT
 
+#define REWIND_BUTTON_CFG CFG_PREFIX "rewind-button"
+#define REWIND_BUTTON_DEFAULT 0 // no rewind
+
+#define REWIND_RATE_CFG CFG_PREFIX "rewind-rate"
+#define REWIND_RATE_DEFAULT 4.0f
+
 #define ACCELERATION_RATE_CFG CFG_PREFIX "rate"
 #define ACCELERATION_RATE_DEFAULT 2.0f
 
+#define SKIM_RATE_CFG CFG_PREFIX "skim-rate"
+#define SKIM_RATE_DEFAULT 0.0f // never skims
+
 #define HOLD_DELAY_CFG CFG_PREFIX "hold-delay"
 #define HOLD_DELAY_DEFAULT 200
 
@@ -21,4 +30,85 @@
 #define EDGE_ACCELERATION_RATE_CFG CFG_PREFIX "edge-rate"
 #define EDGE_ACCELERATION_RATE_DEFAULT 4.0f
 
+#define ZONES_CFG CFG_PREFIX "zones"
+#define ZONES_DEFAULT "" // the edges play at the edge rate
+
+#define RAMP_DURATION_CFG CFG_PREFIX "ramp-duration"
+#define RAMP_DURATION_DEFAULT 0 // ms, 0 switches the rate in a single step
+
+#define RAMP_STEPS_CFG CFG_PREFIX "ramp-steps"
+#define RAMP_STEPS_DEFAULT 8
+
+#define RAMP_CURVE_CFG CFG_PREFIX "ramp-curve"
+#define RAMP_CURVE_DEFAULT 1 // RAMP_CURVE_EXPONENTIAL
+
+#define ADAPTIVE_RATE_CFG CFG_PREFIX "adaptive-rate"
+#define ADAPTIVE_RATE_DEFAULT false
+
+#define MAX_DROP_CFG CFG_PREFIX "max-drop"
+#define MAX_DROP_DEFAULT 10 // % of the decoded pictures
+
+#define SPEED_CONTROL_CFG CFG_PREFIX "speed-control"
+#define SPEED_CONTROL_DEFAULT false
+
+#define DRAG_SPEED_CFG CFG_PREFIX "drag-speed"
+#define DRAG_SPEED_DEFAULT false
+
+#define DRAG_MIN_RATE_CFG CFG_PREFIX "drag-min-rate"
+#define DRAG_MIN_RATE_DEFAULT 0.5f
+
+#define DRAG_MAX_RATE_CFG CFG_PREFIX "drag-max-rate"
+#define DRAG_MAX_RATE_DEFAULT 8.0f
+
+#define DRAG_STEP_CFG CFG_PREFIX "drag-step"
+#define DRAG_STEP_DEFAULT 0.25f
+
+#define AUDIO_BYPASS_CFG CFG_PREFIX "audio-bypass"
+#define AUDIO_BYPASS_DEFAULT 0 // AUDIO_BYPASS_NONE
+
+#define FAST_DECODING_RATE_CFG CFG_PREFIX "fast-decoding-rate"
+#define FAST_DECODING_RATE_DEFAULT 0.0f // never
+
+#define AUTO_SPEED_CFG CFG_PREFIX "auto-speed"
+#define AUTO_SPEED_DEFAULT false
+
+#define AUTO_SPEED_RATE_CFG CFG_PREFIX "auto-speed-rate"
+#define AUTO_SPEED_RATE_DEFAULT 2.0f
+
+#define AUTO_SPEED_THRESHOLD_CFG CFG_PREFIX "auto-speed-threshold"
+#define AUTO_SPEED_THRESHOLD_DEFAULT 1.0f // mean luma difference, out of 255
+
+#define AUTO_SPEED_INTERVAL_CFG CFG_PREFIX "auto-speed-interval"
+#define AUTO_SPEED_INTERVAL_DEFAULT 4 // pictures
+
+#define SILENCE_RATE_CFG CFG_PREFIX "silence-rate"
+#define SILENCE_RATE_DEFAULT 2.0f
+
+#define SILENCE_LEVEL_CFG CFG_PREFIX "silence-level"
+#define SILENCE_LEVEL_DEFAULT -40 // dBFS
+
+#define SILENCE_DURATION_CFG CFG_PREFIX "silence-duration"
+#define SILENCE_DURATION_DEFAULT 500 // ms
+
+#define TRACE_FILE_CFG CFG_PREFIX "trace-file"
+#define TRACE_FILE_DEFAULT "" // no dump when the filter closes
+
+// Setting this variable of the interface to a path dumps the event trace there
+#define TRACE_DUMP_VAR CFG_PREFIX "trace-dump"
+
+#define SPEED_MEMORY_CFG CFG_PREFIX "speed-memory"
+#define SPEED_MEMORY_DEFAULT false // every media starts at the current rate
+
+#define SYNC_GROUP_CFG CFG_PREFIX "sync-group"
+#define SYNC_GROUP_DEFAULT "" // no group
+
+#define MOUSE_CAPTURE_CFG CFG_PREFIX "mouse-capture"
+#define MOUSE_CAPTURE_DEFAULT false // the video filter handles the mouse
+
+#define INPUT_RECORD_CFG CFG_PREFIX "input-record"
+#define INPUT_RECORD_DEFAULT "" // no recording
+
+#define INPUT_REPLAY_CFG CFG_PREFIX "input-replay"
+#define INPUT_REPLAY_DEFAULT "" // no replay
+
 #endif // VLC_SPEED_HOLD_CONFIG_H
\ No newline at end of file
@@ -0,0 +1,370 @@
+#include <vlc_common.h>
+#include <vlc_messages.h>
+#include <vlc_threads.h>
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <errno.h>
+# include <fcntl.h>
+# include <signal.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+#ifdef __linux__
+# include <linux/futex.h>
+# include <sys/syscall.h>
+# include <time.h>
+#endif
+
+#include "compat.h"
+#include "group.h"
+#include "metrics.h"
+
+// Without futexes the members poll the segment at this interval
+#define GROUP_POLL_INTERVAL (CLOCK_FREQ / 1000)
+// Writing takes well under a microsecond, a sequence number still odd after
+// this many tries belongs to a member that stopped or died while writing
+#define GROUP_WRITE_TRIES 100000
+
+// The command slot is guarded by a sequence number: odd while a member writes
+// it, which every member can do, then even. Readers keep a copy only if the
+// number is the same before and after copying. The sequence number is also
+// the futex word the members wait on.
+//
+// The writer stores its process ID once it got the slot. A member that died
+// with the slot locked is replaced by the next publisher, which moves the
+// number to the next odd one, so the readers never take what the dead member
+// left half written.
+typedef struct
+{
+    atomic_uint_least32_t magic;
+    atomic_uint_least32_t seq;
+    atomic_uint_least32_t owner; // process ID of the writer, 0 around the writes
+    group_cmd_t cmd;
+} group_shm_t;
+
+typedef struct
+{
+    vlc_object_t *p_obj;
+    group_shm_t *p_shm;
+#ifdef _WIN32
+    HANDLE mapping;
+#endif
+    uint32_t pid;
+    group_callback_t callback;
+    void *opaque;
+
+    vlc_thread_t thread;
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    atomic_bool quit;
+
+    atomic_uint_fast64_t sent;
+    uint64_t received; // group thread only
+} group_t;
+
+static vlc_mutex_t group_lock = VLC_STATIC_MUTEX;
+static group_t *group_current = NULL;
+// group_current is set, read without the lock
+static atomic_bool group_joined = false;
+
+static group_shm_t *group_map(group_t *p_group, const char *psz_name)
+{
+    char name[GROUP_NAME_MAX + 32];
+
+#ifdef _WIN32
+    snprintf(name, sizeof(name), "Local\\speed-hold-%d-%s", GROUP_VERSION, psz_name);
+    p_group->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                          0, sizeof(group_shm_t), name);
+    if (!p_group->mapping)
+        return NULL;
+
+    // a new mapping is zeroed
+    group_shm_t *p_shm = MapViewOfFile(p_group->mapping, FILE_MAP_WRITE, 0, 0, sizeof(group_shm_t));
+    if (!p_shm)
+        CloseHandle(p_group->mapping);
+    return p_shm;
+#else
+    VLC_UNUSED(p_group);
+    snprintf(name, sizeof(name), "/speed-hold-%d-%s", GROUP_VERSION, psz_name);
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+    if (fd == -1)
+        return NULL;
+
+    // a new segment is zeroed, growing it again changes nothing
+    void *p_shm = MAP_FAILED;
+    if (ftruncate(fd, sizeof(group_shm_t)) == 0)
+        p_shm = mmap(NULL, sizeof(group_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return p_shm == MAP_FAILED ? NULL : p_shm;
+#endif
+}
+
+static void group_unmap(group_t *p_group)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(p_group->p_shm);
+    CloseHandle(p_group->mapping);
+#else
+    // the segment stays for the other members, it's only a few bytes
+    munmap(p_group->p_shm, sizeof(group_shm_t));
+#endif
+}
+
+static void group_wake(group_t *p_group)
+{
+#ifdef __linux__
+    syscall(SYS_futex, &p_group->p_shm->seq, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+#else
+    VLC_UNUSED(p_group);
+#endif
+}
+
+// Returns once the sequence number may have changed from seq, or after a
+// while, or once leaving
+static void group_wait(group_t *p_group, uint32_t seq)
+{
+#ifdef __linux__
+    struct timespec timeout = { 0, 100000000 };
+    syscall(SYS_futex, &p_group->p_shm->seq, FUTEX_WAIT, seq, &timeout, NULL, 0);
+#else
+    VLC_UNUSED(seq);
+    vlc_mutex_lock(&p_group->lock);
+    if (!atomic_load(&p_group->quit))
+        vlc_cond_timedwait(&p_group->wait, &p_group->lock, _vlc_tick_now() + GROUP_POLL_INTERVAL);
+    vlc_mutex_unlock(&p_group->lock);
+#endif
+}
+
+static void *group_thread(void *data)
+{
+    group_t *p_group = data;
+    group_shm_t *p_shm = p_group->p_shm;
+
+    // what was published before joining is left alone
+    uint32_t last = atomic_load_explicit(&p_shm->seq, memory_order_acquire) & ~1u;
+
+    while (!atomic_load(&p_group->quit)) {
+        uint32_t seq = atomic_load_explicit(&p_shm->seq, memory_order_acquire);
+
+        if (seq != last && !(seq & 1)) {
+            group_cmd_t cmd = p_shm->cmd;
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&p_shm->seq, memory_order_relaxed) == seq) {
+                last = seq;
+                if (cmd.sender != p_group->pid) {
+                    metrics_record(METRIC_GROUP_SKEW, _vlc_tick_now() - cmd.date);
+                    p_group->callback(p_group->opaque, &cmd);
+                    p_group->received++;
+                }
+            }
+            continue;
+        }
+
+        group_wait(p_group, seq);
+    }
+
+    return NULL;
+}
+
+// The name ends up in a file name on some systems
+static bool group_name_valid(const char *psz_name)
+{
+    size_t length = strlen(psz_name);
+    if (length == 0 || length > GROUP_NAME_MAX)
+        return false;
+    for (const char *p = psz_name; *p; p++) {
+        if (!isalnum((unsigned char)*p) && *p != '-' && *p != '_')
+            return false;
+    }
+    return true;
+}
+
+int group_join(vlc_object_t *p_obj, const char *psz_name, group_callback_t callback, void *opaque)
+{
+    if (!group_name_valid(psz_name)) {
+        msg_Err(p_obj, "[Speed Hold] Invalid sync group name: %s", psz_name);
+        return VLC_EGENERIC;
+    }
+
+    group_t *p_group = calloc(1, sizeof(group_t));
+    if (!p_group)
+        return VLC_ENOMEM;
+
+    p_group->p_shm = group_map(p_group, psz_name);
+    if (!p_group->p_shm) {
+        msg_Err(p_obj, "[Speed Hold] Couldn't open the memory of sync group %s", psz_name);
+        free(p_group);
+        return VLC_EGENERIC;
+    }
+
+    // the first member to join sets the magic
+    uint_least32_t magic = 0;
+    if (!atomic_compare_exchange_strong(&p_group->p_shm->magic, &magic, GROUP_MAGIC)
+     && magic != GROUP_MAGIC) {
+        msg_Err(p_obj, "[Speed Hold] The memory of sync group %s isn't one", psz_name);
+        group_unmap(p_group);
+        free(p_group);
+        return VLC_EGENERIC;
+    }
+
+    p_group->p_obj = p_obj;
+#ifdef _WIN32
+    p_group->pid = GetCurrentProcessId();
+#else
+    p_group->pid = getpid();
+#endif
+    p_group->callback = callback;
+    p_group->opaque = opaque;
+    vlc_mutex_init(&p_group->lock);
+    vlc_cond_init(&p_group->wait);
+    atomic_init(&p_group->quit, false);
+    atomic_init(&p_group->sent, 0);
+
+    vlc_mutex_lock(&group_lock);
+    bool joined = !group_current;
+    if (joined)
+        group_current = p_group;
+    vlc_mutex_unlock(&group_lock);
+
+    if (!joined || _vlc_clone(&p_group->thread, group_thread, p_group) != VLC_SUCCESS) {
+        msg_Err(p_obj, "[Speed Hold] Couldn't join sync group %s", psz_name);
+        if (joined) {
+            vlc_mutex_lock(&group_lock);
+            group_current = NULL;
+            vlc_mutex_unlock(&group_lock);
+        }
+        _vlc_cond_destroy(&p_group->wait);
+        _vlc_mutex_destroy(&p_group->lock);
+        group_unmap(p_group);
+        free(p_group);
+        return VLC_EGENERIC;
+    }
+
+    atomic_store(&group_joined, true);
+    msg_Dbg(p_obj, "[Speed Hold] joined sync group %s as %" PRIu32, psz_name, p_group->pid);
+    return VLC_SUCCESS;
+}
+
+void group_leave(void)
+{
+    vlc_mutex_lock(&group_lock);
+    group_t *p_group = group_current;
+    group_current = NULL;
+    atomic_store(&group_joined, false);
+    vlc_mutex_unlock(&group_lock);
+
+    if (!p_group)
+        return;
+
+    vlc_mutex_lock(&p_group->lock);
+    atomic_store(&p_group->quit, true);
+    vlc_cond_signal(&p_group->wait);
+    vlc_mutex_unlock(&p_group->lock);
+    // wakes the other members up too, they go back to sleep
+    group_wake(p_group);
+    vlc_join(p_group->thread, NULL);
+
+    msg_Dbg(p_group->p_obj, "[Speed Hold] sync group: %" PRIu64 " commands sent, %" PRIu64 " received",
+            (uint64_t)atomic_load(&p_group->sent), p_group->received);
+
+    _vlc_cond_destroy(&p_group->wait);
+    _vlc_mutex_destroy(&p_group->lock);
+    group_unmap(p_group);
+    free(p_group);
+}
+
+// True if the writer can't finish its write anymore. Without an ID it died
+// right after locking or right before unlocking, or it's stopped, in which
+// case its write is lost.
+static bool group_owner_gone(const group_t *p_group, uint32_t pid)
+{
+    // only this thread writes for this process, so it's a dead one whose ID
+    // was reused
+    if (pid == 0 || pid == p_group->pid)
+        return true;
+#ifdef _WIN32
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!process)
+        return GetLastError() == ERROR_INVALID_PARAMETER;
+    DWORD code;
+    bool gone = GetExitCodeProcess(process, &code) && code != STILL_ACTIVE;
+    CloseHandle(process);
+    return gone;
+#else
+    return kill(pid, 0) == -1 && errno == ESRCH;
+#endif
+}
+
+// Locks the command slot, returns the odd sequence number set, or 0, which
+// isn't odd, on failure
+static uint_least32_t group_lock_slot(group_t *p_group)
+{
+    group_shm_t *p_shm = p_group->p_shm;
+    uint_least32_t seq = atomic_load_explicit(&p_shm->seq, memory_order_relaxed);
+
+    for (unsigned tries = 0; tries < GROUP_WRITE_TRIES; tries++) {
+        if (seq & 1)
+            seq = atomic_load_explicit(&p_shm->seq, memory_order_relaxed);
+        else if (atomic_compare_exchange_weak_explicit(&p_shm->seq, &seq, seq + 1,
+                                                       memory_order_acquire, memory_order_relaxed))
+            return seq + 1;
+    }
+
+    // still locked by the same write, take it over if its writer is gone
+    if (!(seq & 1)
+     || !group_owner_gone(p_group, atomic_load_explicit(&p_shm->owner, memory_order_relaxed))
+     || !atomic_compare_exchange_strong_explicit(&p_shm->seq, &seq, seq + 2,
+                                                 memory_order_acquire, memory_order_relaxed))
+        return 0;
+
+    msg_Warn(p_group->p_obj, "[Speed Hold] A sync group member died while publishing, taking over");
+    return seq + 2;
+}
+
+bool group_is_joined(void)
+{
+    return atomic_load_explicit(&group_joined, memory_order_relaxed);
+}
+
+void group_publish(group_cmd_type_t type, float rate, const ramp_params_t *p_ramp)
+{
+    // held while writing, so that leaving doesn't unmap the segment under it
+    vlc_mutex_lock(&group_lock);
+    group_t *p_group = group_current;
+    if (!p_group) {
+        vlc_mutex_unlock(&group_lock);
+        return;
+    }
+
+    group_shm_t *p_shm = p_group->p_shm;
+    uint_least32_t odd = group_lock_slot(p_group);
+
+    if (odd) {
+        atomic_store_explicit(&p_shm->owner, p_group->pid, memory_order_relaxed);
+        // the odd number has to be visible before any of the command
+        atomic_thread_fence(memory_order_release);
+        p_shm->cmd = (group_cmd_t) {
+            .type = type,
+            .sender = p_group->pid,
+            .rate = rate,
+            .ramp = p_ramp ? *p_ramp : (ramp_params_t) { 0 },
+            .date = _vlc_tick_now(),
+        };
+        atomic_store_explicit(&p_shm->owner, 0, memory_order_relaxed);
+        // fails if another member took the slot over meanwhile, this process
+        // having been stopped for that long
+        if (atomic_compare_exchange_strong_explicit(&p_shm->seq, &odd, odd + 1,
+                                                    memory_order_release, memory_order_relaxed)) {
+            group_wake(p_group);
+            atomic_fetch_add(&p_group->sent, 1);
+        }
+    } else {
+        msg_Warn(p_group->p_obj, "[Speed Hold] The sync group memory stays locked, command dropped");
+    }
+    vlc_mutex_unlock(&group_lock);
+}
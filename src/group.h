@@ -0,0 +1,50 @@
+#ifndef VLC_SPEED_HOLD_GROUP_H
+#define VLC_SPEED_HOLD_GROUP_H
+
+#include <vlc_common.h>
+
+#include "compat.h"
+#include "ramp.h"
+
+// Sync group: VLC processes of the same machine sharing a named memory
+// segment, through which the holds started in one of them are applied by
+// all the others.
+
+#define GROUP_MAGIC 0x50524753 // "SGRP"
+#define GROUP_VERSION 2 // part of the segment name, versions don't meet
+#define GROUP_NAME_MAX 64
+
+typedef enum
+{
+    GROUP_CMD_HOLD, // ramp to the rate
+    GROUP_CMD_SKIM, // negative backwards
+    GROUP_CMD_RELEASE, // ramp back, each member to its rate from before the hold
+} group_cmd_type_t;
+
+typedef struct
+{
+    uint32_t type; // group_cmd_type_t
+    uint32_t sender; // process ID
+    float rate;
+    ramp_params_t ramp;
+    int64_t date; // of the sender's clock, which all the processes share
+} group_cmd_t;
+
+typedef void (*group_callback_t)(void *opaque, const group_cmd_t *p_cmd);
+
+// Joins the group, creating its segment if needed, and calls back from a
+// thread of its own with the commands the other members publish. A member
+// falling behind only gets the latest one. Only one group can be joined per
+// process.
+int group_join(vlc_object_t *p_obj, const char *psz_name, group_callback_t callback, void *opaque);
+// Logs the commands sent and received
+void group_leave(void);
+// Lock-free, for the producers to skip publishing when there is no group
+bool group_is_joined(void);
+
+// Does nothing unless a group was joined. The ramp can be NULL. Takes the
+// group lock and may spin on the shared memory, so the hot paths go through
+// worker_push_group() instead.
+void group_publish(group_cmd_type_t type, float rate, const ramp_params_t *p_ramp);
+
+#endif // VLC_SPEED_HOLD_GROUP_H
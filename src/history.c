@@ -0,0 +1,178 @@
+#include <vlc_common.h>
+#include <vlc_config.h>
+#include <vlc_fs.h>
+#include <vlc_messages.h>
+#include <vlc_threads.h>
+
+#include <fcntl.h>
+#ifdef _WIN32
+# include <io.h>
+# include <windows.h>
+#else
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#include "history.h"
+
+#define HISTORY_SIZE (sizeof(history_header_t) + HISTORY_SLOTS * sizeof(history_slot_t))
+
+// Other processes may write the file at the same time. An entry they race on
+// can be lost, which only forgets a rate.
+static vlc_mutex_t history_lock = VLC_STATIC_MUTEX;
+static history_header_t *history_map = NULL;
+#ifdef _WIN32
+static HANDLE history_mapping = NULL;
+#endif
+
+static history_slot_t *history_slots(void)
+{
+    return (history_slot_t *)(history_map + 1);
+}
+
+static void *history_map_file(int fd)
+{
+#ifdef _WIN32
+    // the mapping grows the file to its size
+    history_mapping = CreateFileMappingW((HANDLE)_get_osfhandle(fd), NULL, PAGE_READWRITE,
+                                         0, HISTORY_SIZE, NULL);
+    if (!history_mapping)
+        return NULL;
+
+    void *p_map = MapViewOfFile(history_mapping, FILE_MAP_WRITE, 0, 0, HISTORY_SIZE);
+    if (!p_map) {
+        CloseHandle(history_mapping);
+        history_mapping = NULL;
+    }
+    return p_map;
+#else
+    // the new part of the file is sparse and reads as free slots
+    struct stat st;
+    if (fstat(fd, &st) != 0
+     || (st.st_size != (off_t)HISTORY_SIZE && ftruncate(fd, HISTORY_SIZE) != 0))
+        return NULL;
+
+    void *p_map = mmap(NULL, HISTORY_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return p_map == MAP_FAILED ? NULL : p_map;
+#endif
+}
+
+static void history_unmap(void)
+{
+#ifdef _WIN32
+    FlushViewOfFile(history_map, 0);
+    UnmapViewOfFile(history_map);
+    CloseHandle(history_mapping);
+    history_mapping = NULL;
+#else
+    msync(history_map, HISTORY_SIZE, MS_ASYNC);
+    munmap(history_map, HISTORY_SIZE);
+#endif
+    history_map = NULL;
+}
+
+int history_open(vlc_object_t *p_obj)
+{
+    char *psz_dir = config_GetUserDir(VLC_USERDATA_DIR);
+    if (!psz_dir)
+        return VLC_ENOMEM;
+
+    char *psz_path;
+    if (asprintf(&psz_path, "%s" DIR_SEP HISTORY_FILE, psz_dir) == -1) {
+        free(psz_dir);
+        return VLC_ENOMEM;
+    }
+    // fails when it exists already, opening the file then tells
+    vlc_mkdir(psz_dir, 0700);
+    free(psz_dir);
+
+    int ret = VLC_SUCCESS;
+
+    vlc_mutex_lock(&history_lock);
+    if (!history_map) {
+        int fd = vlc_open(psz_path, O_RDWR | O_CREAT, 0600);
+        if (fd != -1) {
+            history_map = history_map_file(fd);
+            close(fd);
+        }
+
+        if (!history_map) {
+            msg_Warn(p_obj, "[Speed Hold] Couldn't map the speed memory file %s", psz_path);
+            ret = VLC_EGENERIC;
+        } else if (history_map->magic != HISTORY_MAGIC || history_map->version != HISTORY_VERSION
+                || history_map->slots != HISTORY_SLOTS) {
+            msg_Dbg(p_obj, "[Speed Hold] Initializing the speed memory file %s", psz_path);
+            memset(history_map, 0, HISTORY_SIZE);
+            history_map->version = HISTORY_VERSION;
+            history_map->slots = HISTORY_SLOTS;
+            history_map->magic = HISTORY_MAGIC;
+        }
+    }
+    vlc_mutex_unlock(&history_lock);
+
+    free(psz_path);
+    return ret;
+}
+
+void history_close(void)
+{
+    vlc_mutex_lock(&history_lock);
+    if (history_map)
+        history_unmap();
+    vlc_mutex_unlock(&history_lock);
+}
+
+// FNV-1a
+uint64_t history_key(const char *psz_uri)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char *p = (const unsigned char *)psz_uri; *p; p++) {
+        hash ^= *p;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash ? hash : 1;
+}
+
+bool history_lookup(uint64_t key, history_entry_t *p_entry)
+{
+    bool found = false;
+
+    vlc_mutex_lock(&history_lock);
+    if (history_map) {
+        history_slot_t *p_slots = history_slots();
+        for (size_t i = 0; i < HISTORY_PROBES; i++) {
+            history_slot_t *p_slot = &p_slots[(key + i) & (HISTORY_SLOTS - 1)];
+            if (p_slot->key == 0)
+                break;
+            if (p_slot->key == key) {
+                *p_entry = p_slot->entry;
+                found = true;
+                break;
+            }
+        }
+    }
+    vlc_mutex_unlock(&history_lock);
+
+    return found;
+}
+
+// Only touches the memory, the system writes the pages back to the file
+void history_store(uint64_t key, const history_entry_t *p_entry)
+{
+    vlc_mutex_lock(&history_lock);
+    if (history_map) {
+        history_slot_t *p_slots = history_slots();
+        history_slot_t *p_target = &p_slots[key & (HISTORY_SLOTS - 1)];
+        for (size_t i = 0; i < HISTORY_PROBES; i++) {
+            history_slot_t *p_slot = &p_slots[(key + i) & (HISTORY_SLOTS - 1)];
+            if (p_slot->key == key || p_slot->key == 0) {
+                p_target = p_slot;
+                break;
+            }
+        }
+        p_target->entry = *p_entry;
+        p_target->key = key;
+    }
+    vlc_mutex_unlock(&history_lock);
+}
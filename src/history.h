@@ -0,0 +1,50 @@
+#ifndef VLC_SPEED_HOLD_HISTORY_H
+#define VLC_SPEED_HOLD_HISTORY_H
+
+#include <vlc_common.h>
+
+// Rates last used per media, kept in a memory mapped file shared by every
+// VLC instance of the user. Opening it maps the file without reading it, so
+// it costs the same whatever the number of media remembered.
+
+#define HISTORY_FILE "speed_hold_history.bin"
+#define HISTORY_MAGIC 0x4d484853 // "SHHM"
+#define HISTORY_VERSION 1
+#define HISTORY_SLOTS (1 << 18) // a power of 2, 4 MiB of slots
+#define HISTORY_PROBES 16 // the home slot is overwritten past this many
+
+// File: the header followed by the slots, both in host byte order. A slot is
+// free while its key is 0.
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t reserved;
+} history_header_t;
+
+typedef struct
+{
+    float base_rate; // 0 if unknown
+    float hold_rate; // 0 if no hold happened
+} history_entry_t;
+
+typedef struct
+{
+    uint64_t key;
+    history_entry_t entry;
+} history_slot_t;
+
+// Maps the file from the user data directory, creating it if needed. Only
+// one mapping is kept per process.
+int history_open(vlc_object_t *p_obj);
+// Schedules the changes for writing and unmaps the file
+void history_close(void);
+
+// Never 0
+uint64_t history_key(const char *psz_uri);
+// Both do nothing while the file isn't mapped
+bool history_lookup(uint64_t key, history_entry_t *p_entry);
+void history_store(uint64_t key, const history_entry_t *p_entry);
+
+#endif // VLC_SPEED_HOLD_HISTORY_H
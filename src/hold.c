@@ -0,0 +1,48 @@
+#include "hold.h"
+
+void hold_init(hold_t *p_hold)
+{
+    atomic_init(&p_hold->state, HOLD_IDLE);
+}
+
+void hold_press(hold_t *p_hold)
+{
+    atomic_store(&p_hold->state, HOLD_PENDING);
+}
+
+bool hold_fire(hold_t *p_hold)
+{
+    int state = HOLD_PENDING;
+    return atomic_compare_exchange_strong(&p_hold->state, &state, HOLD_FIRING);
+}
+
+void hold_fired(hold_t *p_hold)
+{
+    atomic_store(&p_hold->state, HOLD_ACTIVE);
+}
+
+bool hold_is_active(hold_t *p_hold)
+{
+    return atomic_load(&p_hold->state) == HOLD_ACTIVE;
+}
+
+bool hold_is_idle(hold_t *p_hold)
+{
+    return atomic_load(&p_hold->state) == HOLD_IDLE;
+}
+
+hold_release_t hold_release(hold_t *p_hold)
+{
+    int state = atomic_load(&p_hold->state);
+    while (state == HOLD_FIRING || !atomic_compare_exchange_weak(&p_hold->state, &state, HOLD_IDLE))
+        state = atomic_load(&p_hold->state);
+
+    switch (state) {
+        case HOLD_PENDING:
+            return HOLD_RELEASE_CLICK;
+        case HOLD_ACTIVE:
+            return HOLD_RELEASE_RESTORE;
+        default:
+            return HOLD_RELEASE_NONE;
+    }
+}
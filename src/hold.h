@@ -0,0 +1,52 @@
+#ifndef VLC_SPEED_HOLD_HOLD_H
+#define VLC_SPEED_HOLD_HOLD_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// Click/hold state machine driven by mouse() and the hold timer, which run on
+// different threads. It doesn't depend on libvlccore, so press/fire/release
+// sequences can be replayed against it without a running VLC.
+//
+// PENDING: button down, hold timer armed
+// FIRING: timer claimed the hold and is pushing the acceleration commands
+// ACTIVE: acceleration commands are queued, release has to restore the rate
+enum
+{
+    HOLD_IDLE,
+    HOLD_PENDING,
+    HOLD_FIRING,
+    HOLD_ACTIVE,
+};
+
+typedef enum
+{
+    HOLD_RELEASE_NONE, // release without a press seen by this instance
+    HOLD_RELEASE_CLICK,
+    HOLD_RELEASE_RESTORE,
+} hold_release_t;
+
+typedef struct
+{
+    atomic_int state;
+} hold_t;
+
+void hold_init(hold_t *p_hold);
+void hold_press(hold_t *p_hold);
+
+// Called from the timer. Returns true if the press turned into a hold, the
+// caller then pushes its commands and calls hold_fired().
+bool hold_fire(hold_t *p_hold);
+void hold_fired(hold_t *p_hold);
+// True once hold_fired() was called and until the release
+bool hold_is_active(hold_t *p_hold);
+// True while the button isn't held
+bool hold_is_idle(hold_t *p_hold);
+
+// Moves back to idle and tells what the press turned out to be. Resetting
+// also keeps a timer that is about to fire from accelerating. A timer that
+// is still pushing its commands is waited for, which is bounded since
+// pushing never blocks, so the restore is always queued after them.
+hold_release_t hold_release(hold_t *p_hold);
+
+#endif // VLC_SPEED_HOLD_HOLD_H
@@ -0,0 +1,75 @@
+#include <vlc_common.h>
+
+#include "compat.h"
+#include "keyframes.h"
+
+void keyframes_init(keyframes_t *p_keyframes)
+{
+    p_keyframes->p_times = NULL;
+    p_keyframes->count = 0;
+    p_keyframes->size = 0;
+}
+
+void keyframes_clean(keyframes_t *p_keyframes)
+{
+    free(p_keyframes->p_times);
+    keyframes_init(p_keyframes);
+}
+
+void keyframes_reset(keyframes_t *p_keyframes)
+{
+    p_keyframes->count = 0;
+}
+
+// Index of the first keyframe after the time
+static size_t keyframes_upper(const keyframes_t *p_keyframes, _vlc_tick_t time)
+{
+    size_t low = 0;
+    size_t high = p_keyframes->count;
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (p_keyframes->p_times[mid] <= time)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+void keyframes_add(keyframes_t *p_keyframes, _vlc_tick_t time)
+{
+    if (time < 0)
+        return;
+
+    // the estimates are early, the latest one of a keyframe is kept
+    size_t index = keyframes_upper(p_keyframes, time);
+    if (index > 0 && time - p_keyframes->p_times[index - 1] < KEYFRAMES_TOLERANCE) {
+        p_keyframes->p_times[index - 1] = time;
+        return;
+    }
+    if (index < p_keyframes->count && p_keyframes->p_times[index] - time < KEYFRAMES_TOLERANCE)
+        return;
+
+    if (p_keyframes->count == p_keyframes->size) {
+        if (p_keyframes->size == KEYFRAMES_MAX)
+            return;
+        size_t size = p_keyframes->size ? p_keyframes->size * 2 : 64;
+        _vlc_tick_t *p_times = realloc(p_keyframes->p_times, size * sizeof(_vlc_tick_t));
+        if (!p_times)
+            return;
+        p_keyframes->p_times = p_times;
+        p_keyframes->size = size;
+    }
+
+    memmove(&p_keyframes->p_times[index + 1], &p_keyframes->p_times[index],
+            (p_keyframes->count - index) * sizeof(_vlc_tick_t));
+    p_keyframes->p_times[index] = time;
+    p_keyframes->count++;
+}
+
+_vlc_tick_t keyframes_find(const keyframes_t *p_keyframes, _vlc_tick_t time)
+{
+    size_t index = keyframes_upper(p_keyframes, time);
+    return index > 0 ? p_keyframes->p_times[index - 1] : -1;
+}
@@ -0,0 +1,33 @@
+#ifndef VLC_SPEED_HOLD_KEYFRAMES_H
+#define VLC_SPEED_HOLD_KEYFRAMES_H
+
+#include <vlc_common.h>
+
+#include "compat.h"
+
+// Keyframe times of the current media, learned from where the fast seeks of
+// the skims land, as VLC doesn't tell them to an interface
+
+#define KEYFRAMES_MAX 65536 // later keyframes aren't learned
+// Landings closer than this are taken for the same keyframe. The estimated
+// times are early by up to the time the decoder took to start, seeking this
+// far after one lands on it.
+#define KEYFRAMES_TOLERANCE (CLOCK_FREQ / 10)
+
+typedef struct
+{
+    _vlc_tick_t *p_times; // sorted
+    size_t count;
+    size_t size;
+} keyframes_t;
+
+void keyframes_init(keyframes_t *p_keyframes);
+void keyframes_clean(keyframes_t *p_keyframes);
+// Forgets the keyframes, keeping the memory for the next media
+void keyframes_reset(keyframes_t *p_keyframes);
+
+void keyframes_add(keyframes_t *p_keyframes, _vlc_tick_t time);
+// Latest keyframe at or before the time, -1 if none is known
+_vlc_tick_t keyframes_find(const keyframes_t *p_keyframes, _vlc_tick_t time);
+
+#endif // VLC_SPEED_HOLD_KEYFRAMES_H
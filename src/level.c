@@ -0,0 +1,147 @@
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include <math.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+# include <immintrin.h>
+#elif defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
+
+#include "level.h"
+
+static void accumulate_c(const float *p_samples, size_t count, float *p_sum_squares, float *p_peak)
+{
+    float sum = 0.f;
+    float peak = *p_peak;
+
+    for (size_t i = 0; i < count; i++) {
+        sum += p_samples[i] * p_samples[i];
+        if (fabsf(p_samples[i]) > peak)
+            peak = fabsf(p_samples[i]);
+    }
+
+    *p_sum_squares += sum;
+    *p_peak = peak;
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+__attribute__((target("sse")))
+static void accumulate_sse(const float *p_samples, size_t count, float *p_sum_squares, float *p_peak)
+{
+    const __m128 sign = _mm_set1_ps(-0.f);
+    __m128 sum = _mm_setzero_ps();
+    __m128 peak = _mm_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(p_samples + i);
+        sum = _mm_add_ps(sum, _mm_mul_ps(x, x));
+        peak = _mm_max_ps(peak, _mm_andnot_ps(sign, x));
+    }
+
+    float sums[4], peaks[4];
+    _mm_storeu_ps(sums, sum);
+    _mm_storeu_ps(peaks, peak);
+    for (int j = 0; j < 4; j++) {
+        *p_sum_squares += sums[j];
+        if (peaks[j] > *p_peak)
+            *p_peak = peaks[j];
+    }
+
+    accumulate_c(p_samples + i, count - i, p_sum_squares, p_peak);
+}
+
+__attribute__((target("avx")))
+static void accumulate_avx(const float *p_samples, size_t count, float *p_sum_squares, float *p_peak)
+{
+    const __m256 sign = _mm256_set1_ps(-0.f);
+    __m256 sum = _mm256_setzero_ps();
+    __m256 peak = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(p_samples + i);
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(x, x));
+        peak = _mm256_max_ps(peak, _mm256_andnot_ps(sign, x));
+    }
+
+    float sums[8], peaks[8];
+    _mm256_storeu_ps(sums, sum);
+    _mm256_storeu_ps(peaks, peak);
+    for (int j = 0; j < 8; j++) {
+        *p_sum_squares += sums[j];
+        if (peaks[j] > *p_peak)
+            *p_peak = peaks[j];
+    }
+
+    accumulate_c(p_samples + i, count - i, p_sum_squares, p_peak);
+}
+#elif defined(__ARM_NEON)
+static void accumulate_neon(const float *p_samples, size_t count, float *p_sum_squares, float *p_peak)
+{
+    float32x4_t sum = vdupq_n_f32(0.f);
+    float32x4_t peak = vdupq_n_f32(0.f);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t x = vld1q_f32(p_samples + i);
+        sum = vmlaq_f32(sum, x, x);
+        peak = vmaxq_f32(peak, vabsq_f32(x));
+    }
+
+    float sums[4], peaks[4];
+    vst1q_f32(sums, sum);
+    vst1q_f32(peaks, peak);
+    for (int j = 0; j < 4; j++) {
+        *p_sum_squares += sums[j];
+        if (peaks[j] > *p_peak)
+            *p_peak = peaks[j];
+    }
+
+    accumulate_c(p_samples + i, count - i, p_sum_squares, p_peak);
+}
+#endif
+
+void level_init(level_t *p_level)
+{
+    p_level->accumulate = accumulate_c;
+#if defined(__i386__) || defined(__x86_64__)
+    if (vlc_CPU_AVX())
+        p_level->accumulate = accumulate_avx;
+    else if (vlc_CPU_SSE())
+        p_level->accumulate = accumulate_sse;
+#elif defined(__ARM_NEON)
+    p_level->accumulate = accumulate_neon;
+#endif
+    level_reset(p_level);
+}
+
+void level_reset(level_t *p_level)
+{
+    p_level->sum_squares = 0.;
+    p_level->peak = 0.f;
+    p_level->samples = 0;
+}
+
+void level_add(level_t *p_level, const float *p_samples, size_t count)
+{
+    // a block is short enough for a float sum, the total is kept as a double
+    float sum_squares = 0.f;
+    p_level->accumulate(p_samples, count, &sum_squares, &p_level->peak);
+    p_level->sum_squares += sum_squares;
+    p_level->samples += count;
+}
+
+float level_rms_db(const level_t *p_level)
+{
+    if (p_level->samples == 0)
+        return -INFINITY;
+    return 10.f * log10f(p_level->sum_squares / p_level->samples);
+}
+
+float level_peak_db(const level_t *p_level)
+{
+    return 20.f * log10f(p_level->peak);
+}
@@ -0,0 +1,24 @@
+#ifndef VLC_SPEED_HOLD_LEVEL_H
+#define VLC_SPEED_HOLD_LEVEL_H
+
+#include <vlc_common.h>
+
+// Loudness of interleaved float samples, accumulated over any number of
+// blocks until level_reset()
+typedef struct
+{
+    double sum_squares;
+    float peak;
+    size_t samples;
+    void (*accumulate)(const float *p_samples, size_t count, float *p_sum_squares, float *p_peak);
+} level_t;
+
+void level_init(level_t *p_level);
+void level_reset(level_t *p_level);
+void level_add(level_t *p_level, const float *p_samples, size_t count);
+
+// In dBFS, -INFINITY for digital silence
+float level_rms_db(const level_t *p_level);
+float level_peak_db(const level_t *p_level);
+
+#endif // VLC_SPEED_HOLD_LEVEL_H
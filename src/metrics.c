@@ -0,0 +1,130 @@
+#include <vlc_common.h>
+#include <vlc_variables.h>
+
+#include <inttypes.h>
+#include <stdatomic.h>
+
+#include "compat.h"
+#include "metrics.h"
+
+#define METRICS_BUCKETS 24 // powers of 2 microseconds, up to ~8 s
+#define METRICS_TEXT_SIZE 96
+
+typedef struct
+{
+    atomic_uint_fast32_t buckets[METRICS_BUCKETS];
+    atomic_uint_fast64_t count;
+    atomic_int_fast64_t max;
+} histogram_t;
+
+static const struct
+{
+    const char *var;
+    const char *name;
+} metrics_names[METRIC_COUNT] =
+{
+    [METRIC_TIMER_JITTER] = { "speed-hold-latency-timer-jitter", "hold timer jitter" },
+    [METRIC_QUEUE_WAIT] = { "speed-hold-latency-queue-wait", "worker queue wait" },
+    [METRIC_SET_RATE] = { "speed-hold-latency-set-rate", "SetRate()" },
+    [METRIC_OSD] = { "speed-hold-latency-osd", "OSD update" },
+    [METRIC_PRESS_TO_RATE] = { "speed-hold-latency-press-to-rate", "press to rate" },
+    [METRIC_CLICK_TO_PAUSE] = { "speed-hold-latency-click-to-pause", "click to pause/play" },
+    [METRIC_GROUP_SKEW] = { "speed-hold-latency-group-skew", "sync group skew" },
+};
+
+static histogram_t metrics[METRIC_COUNT];
+static atomic_bool metrics_dirty;
+
+void metrics_record(metric_t metric, _vlc_tick_t latency)
+{
+    histogram_t *p_histogram = &metrics[metric];
+
+    if (latency < 0)
+        latency = 0;
+
+    unsigned bucket = 0;
+    while (bucket + 1 < METRICS_BUCKETS && latency >= (_vlc_tick_t)1 << (bucket + 1))
+        bucket++;
+
+    atomic_fetch_add_explicit(&p_histogram->buckets[bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&p_histogram->count, 1, memory_order_relaxed);
+
+    int_fast64_t max = atomic_load_explicit(&p_histogram->max, memory_order_relaxed);
+    while (latency > max && !atomic_compare_exchange_weak_explicit(&p_histogram->max, &max, latency,
+                                                                  memory_order_relaxed, memory_order_relaxed))
+        ;
+
+    atomic_store_explicit(&metrics_dirty, true, memory_order_release);
+}
+
+// Upper bound of the bucket holding the given share of the samples
+static uint64_t histogram_percentile(const uint_fast32_t *p_buckets, uint64_t count, unsigned percent)
+{
+    uint64_t rank = (count * percent + 99) / 100;
+    uint64_t seen = 0;
+
+    for (unsigned b = 0; b < METRICS_BUCKETS; b++) {
+        seen += p_buckets[b];
+        if (seen >= rank)
+            return (uint64_t)1 << (b + 1);
+    }
+
+    return (uint64_t)1 << METRICS_BUCKETS;
+}
+
+static void histogram_format(const histogram_t *p_histogram, char *text, size_t size)
+{
+    uint_fast32_t buckets[METRICS_BUCKETS];
+    uint64_t count = 0;
+
+    // the total is summed from the copied buckets, so that it matches them
+    for (unsigned b = 0; b < METRICS_BUCKETS; b++) {
+        buckets[b] = atomic_load_explicit(&p_histogram->buckets[b], memory_order_relaxed);
+        count += buckets[b];
+    }
+
+    if (count == 0) {
+        snprintf(text, size, "n=0");
+        return;
+    }
+
+    snprintf(text, size, "n=%" PRIu64 " p50<%" PRIu64 "us p90<%" PRIu64 "us p99<%" PRIu64 "us max=%" PRId64 "us",
+             count, histogram_percentile(buckets, count, 50), histogram_percentile(buckets, count, 90),
+             histogram_percentile(buckets, count, 99),
+             (int64_t)atomic_load_explicit(&p_histogram->max, memory_order_relaxed));
+}
+
+void metrics_create_vars(vlc_object_t *p_obj)
+{
+    for (unsigned i = 0; i < METRIC_COUNT; i++)
+        var_Create(p_obj, metrics_names[i].var, VLC_VAR_STRING);
+    atomic_store(&metrics_dirty, true);
+    metrics_publish(p_obj);
+}
+
+void metrics_destroy_vars(vlc_object_t *p_obj)
+{
+    for (unsigned i = 0; i < METRIC_COUNT; i++)
+        var_Destroy(p_obj, metrics_names[i].var);
+}
+
+void metrics_publish(vlc_object_t *p_obj)
+{
+    if (!atomic_exchange_explicit(&metrics_dirty, false, memory_order_acquire))
+        return;
+
+    for (unsigned i = 0; i < METRIC_COUNT; i++) {
+        char text[METRICS_TEXT_SIZE];
+        histogram_format(&metrics[i], text, sizeof(text));
+        var_SetString(p_obj, metrics_names[i].var, text);
+    }
+}
+
+void metrics_log(vlc_object_t *p_obj)
+{
+    for (unsigned i = 0; i < METRIC_COUNT; i++) {
+        char text[METRICS_TEXT_SIZE];
+        histogram_format(&metrics[i], text, sizeof(text));
+        msg_Dbg(p_obj, "[Speed Hold] latency of %s: %s", metrics_names[i].name, text);
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef VLC_SPEED_HOLD_METRICS_H
+#define VLC_SPEED_HOLD_METRICS_H
+
+#include <vlc_common.h>
+
+#include "compat.h"
+
+// Process-wide latency histograms of the stages between a press and its
+// effect. Recording is lock-free from any thread.
+typedef enum
+{
+    METRIC_TIMER_JITTER, // hold timer fire date past its deadline
+    METRIC_QUEUE_WAIT, // command push to execution by the worker
+    METRIC_SET_RATE, // SetRate(), mostly waiting for the player lock
+    METRIC_OSD, // sending an OSD text to the video output(s)
+    METRIC_PRESS_TO_RATE, // press to the first rate of its hold being set
+    METRIC_CLICK_TO_PAUSE, // click release to the pause/play being done
+    METRIC_GROUP_SKEW, // command published by a sync group member to it reaching this one
+    METRIC_COUNT,
+} metric_t;
+
+void metrics_record(metric_t metric, _vlc_tick_t latency);
+
+// Each histogram is mirrored by a string variable of the object, e.g.
+// speed-hold-latency-set-rate = "n=42 p50<64us p90<256us p99<1024us max=913us"
+void metrics_create_vars(vlc_object_t *p_obj);
+void metrics_destroy_vars(vlc_object_t *p_obj);
+// Refreshes the variables if something was recorded since the last call
+void metrics_publish(vlc_object_t *p_obj);
+void metrics_log(vlc_object_t *p_obj);
+
+#endif // VLC_SPEED_HOLD_METRICS_H
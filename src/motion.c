@@ -0,0 +1,142 @@
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+# include <immintrin.h>
+#elif defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
+
+#include "motion.h"
+
+static uint64_t sad_update_c(uint8_t *p_prev, const uint8_t *p_cur, size_t size)
+{
+    uint64_t sad = 0;
+
+    for (size_t i = 0; i < size; i++) {
+        sad += abs(p_cur[i] - p_prev[i]);
+        p_prev[i] = p_cur[i];
+    }
+
+    return sad;
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+// The 64-bit lanes of the sums stay far below 2^32 for a row of a picture, so
+// only their low halves are extracted, which also works on 32-bit builds
+__attribute__((target("sse2")))
+static uint64_t sad_update_sse2(uint8_t *p_prev, const uint8_t *p_cur, size_t size)
+{
+    __m128i sum = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i cur = _mm_loadu_si128((const __m128i *)(p_cur + i));
+        __m128i prev = _mm_loadu_si128((const __m128i *)(p_prev + i));
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(cur, prev));
+        _mm_storeu_si128((__m128i *)(p_prev + i), cur);
+    }
+
+    uint64_t sad = (uint32_t)_mm_cvtsi128_si32(sum)
+                 + (uint32_t)_mm_cvtsi128_si32(_mm_unpackhi_epi64(sum, sum));
+
+    return sad + sad_update_c(p_prev + i, p_cur + i, size - i);
+}
+
+__attribute__((target("avx2")))
+static uint64_t sad_update_avx2(uint8_t *p_prev, const uint8_t *p_cur, size_t size)
+{
+    __m256i sum = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 32 <= size; i += 32) {
+        __m256i cur = _mm256_loadu_si256((const __m256i *)(p_cur + i));
+        __m256i prev = _mm256_loadu_si256((const __m256i *)(p_prev + i));
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(cur, prev));
+        _mm256_storeu_si256((__m256i *)(p_prev + i), cur);
+    }
+
+    __m128i sum128 = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    uint64_t sad = (uint32_t)_mm_cvtsi128_si32(sum128)
+                 + (uint32_t)_mm_cvtsi128_si32(_mm_unpackhi_epi64(sum128, sum128));
+
+    return sad + sad_update_c(p_prev + i, p_cur + i, size - i);
+}
+#elif defined(__ARM_NEON)
+static uint64_t sad_update_neon(uint8_t *p_prev, const uint8_t *p_cur, size_t size)
+{
+    uint32x4_t sum = vdupq_n_u32(0);
+    size_t i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t cur = vld1q_u8(p_cur + i);
+        uint8x16_t prev = vld1q_u8(p_prev + i);
+        sum = vpadalq_u16(sum, vpaddlq_u8(vabdq_u8(cur, prev)));
+        vst1q_u8(p_prev + i, cur);
+    }
+
+    uint64x2_t sum64 = vpaddlq_u32(sum);
+    uint64_t sad = vgetq_lane_u64(sum64, 0) + vgetq_lane_u64(sum64, 1);
+
+    return sad + sad_update_c(p_prev + i, p_cur + i, size - i);
+}
+#endif
+
+void motion_init(motion_t *p_motion)
+{
+    memset(p_motion, 0, sizeof(*p_motion));
+
+    p_motion->sad_update = sad_update_c;
+#if defined(__i386__) || defined(__x86_64__)
+    if (vlc_CPU_AVX2())
+        p_motion->sad_update = sad_update_avx2;
+    else if (vlc_CPU_SSE2())
+        p_motion->sad_update = sad_update_sse2;
+#elif defined(__ARM_NEON)
+    p_motion->sad_update = sad_update_neon;
+#endif
+}
+
+void motion_clean(motion_t *p_motion)
+{
+    free(p_motion->p_prev);
+    p_motion->p_prev = NULL;
+    p_motion->primed = false;
+}
+
+float motion_compare(motion_t *p_motion, const uint8_t *p_plane, size_t pitch,
+                     unsigned width, unsigned lines)
+{
+    unsigned rows = (lines + MOTION_ROW_STEP - 1) / MOTION_ROW_STEP;
+
+    if (width == 0 || rows == 0)
+        return -1.f;
+
+    if (p_motion->width != width || p_motion->rows != rows) {
+        free(p_motion->p_prev);
+        p_motion->p_prev = malloc((size_t)width * rows);
+        p_motion->width = p_motion->p_prev ? width : 0;
+        p_motion->rows = p_motion->p_prev ? rows : 0;
+        p_motion->primed = false;
+        if (!p_motion->p_prev)
+            return -1.f;
+    }
+
+    uint64_t sad = 0;
+    uint8_t *p_prev = p_motion->p_prev;
+    for (unsigned row = 0; row < rows; row++) {
+        sad += p_motion->sad_update(p_prev, p_plane, width);
+        p_prev += width;
+        p_plane += pitch * MOTION_ROW_STEP;
+    }
+
+    if (!p_motion->primed) {
+        p_motion->primed = true;
+        return -1.f;
+    }
+
+    return (float)sad / ((uint64_t)width * rows);
+}
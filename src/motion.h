@@ -0,0 +1,30 @@
+#ifndef VLC_SPEED_HOLD_MOTION_H
+#define VLC_SPEED_HOLD_MOTION_H
+
+#include <vlc_common.h>
+
+// Only every MOTION_ROW_STEP-th luma row is compared, which is plenty to tell
+// a static scene from a moving one
+#define MOTION_ROW_STEP 8
+
+// Frame difference between consecutive analysed pictures. It keeps a copy of
+// the sampled rows of the last picture, which the comparison overwrites as it
+// goes, so each sampled byte is read once and written once.
+typedef struct
+{
+    uint8_t *p_prev;
+    unsigned width;
+    unsigned rows;
+    bool primed;
+    uint64_t (*sad_update)(uint8_t *p_prev, const uint8_t *p_cur, size_t size);
+} motion_t;
+
+void motion_init(motion_t *p_motion);
+void motion_clean(motion_t *p_motion);
+
+// Mean absolute difference per sampled pixel with the previous call, between
+// 0 and 255. Returns -1 for the first picture or after a size change.
+float motion_compare(motion_t *p_motion, const uint8_t *p_plane, size_t pitch,
+                     unsigned width, unsigned lines);
+
+#endif // VLC_SPEED_HOLD_MOTION_H
@@ -5,10 +5,13 @@
 #include <vlc_player.h>
 #endif
 #include <vlc_playlist.h>
+#include <vlc_vout.h>
 #include <vlc_vout_osd.h>
 #include <vlc_spu.h>
-#include "config.h"
+#include "compat.h"
+#include "metrics.h"
 #include "osd.h"
+#include "trace.h"
 
 void display_speed_text(intf_thread_t *p_intf_thread, const char* text)
 {
@@ -16,13 +19,8 @@ void display_speed_text(intf_thread_t *p_intf_thread, const char* text)
         return;
     }
 
-    if (!var_InheritBool((vlc_object_t*)p_intf_thread, DISPLAY_SPEED_CFG)) {
-        if (text[0] == '\0') { // still allow clearing the text
-            // fall through
-        } else {
-            return;
-        }
-    }
+    trace_record(TRACE_OSD, 0.f);
+    _vlc_tick_t start = _vlc_tick_now();
 
 #if LIBVLC_VERSION_MAJOR >= 4
     vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_intf_thread));
@@ -40,6 +38,7 @@ void display_speed_text(intf_thread_t *p_intf_thread, const char* text)
     }
     vlc_player_Unlock(player);
     free(pp_vout);
+    metrics_record(METRIC_OSD, _vlc_tick_now() - start);
 #else
     playlist_t* p_playlist = pl_Get(p_intf_thread);
     input_thread_t* p_input = playlist_CurrentInput(p_playlist);
@@ -59,5 +58,173 @@ void display_speed_text(intf_thread_t *p_intf_thread, const char* text)
     }
     vlc_object_release(p_input);
     free(pp_vout);
+    metrics_record(METRIC_OSD, _vlc_tick_now() - start);
+#endif
+}
+
+void format_speed_text(char *text, size_t size, float rate)
+{
+    if (rate == (float)(int)rate) {
+        snprintf(text, size, "%dx", (int)rate);
+    } else {
+        snprintf(text, size, "%.2fx", rate);
+    }
+}
+
+static void osd_vout_hold(vout_thread_t *p_vout)
+{
+#if LIBVLC_VERSION_MAJOR >= 4
+    vout_Hold(p_vout);
+#else
+    vlc_object_hold(p_vout);
+#endif
+}
+
+static void osd_vout_release(vout_thread_t *p_vout)
+{
+#if LIBVLC_VERSION_MAJOR >= 4
+    vout_Release(p_vout);
+#else
+    vlc_object_release((vlc_object_t *)p_vout);
 #endif
-}
\ No newline at end of file
+}
+
+// Video filters of the display chain are created by the video output itself,
+// NULL for other chains, e.g. when transcoding
+static vout_thread_t *osd_filter_vout(vlc_object_t *p_filter)
+{
+#if LIBVLC_VERSION_MAJOR >= 4
+    vlc_object_t *p_parent = vlc_object_parent(p_filter);
+    if (!p_parent || strcmp(vlc_object_typename(p_parent), "video output"))
+        return NULL;
+#else
+    vlc_object_t *p_parent = p_filter->obj.parent;
+    if (!p_parent || strcmp(p_parent->obj.object_type, "video output"))
+        return NULL;
+#endif
+    return (vout_thread_t *)p_parent;
+}
+
+void osd_init(osd_t *p_osd)
+{
+    vlc_mutex_init(&p_osd->lock);
+    p_osd->p_vout = NULL;
+    p_osd->vout_changed = false;
+    p_osd->shown[0] = '\0';
+    p_osd->has_pending = false;
+    p_osd->next = 0;
+    p_osd->sent = 0;
+    p_osd->skipped = 0;
+}
+
+void osd_clean(osd_t *p_osd)
+{
+    if (p_osd->p_vout)
+        osd_vout_release(p_osd->p_vout);
+    _vlc_mutex_destroy(&p_osd->lock);
+}
+
+void osd_attach_vout(osd_t *p_osd, vlc_object_t *p_filter)
+{
+    vout_thread_t *p_vout = osd_filter_vout(p_filter);
+    if (!p_vout)
+        return;
+
+    osd_vout_hold(p_vout);
+    vlc_mutex_lock(&p_osd->lock);
+    vout_thread_t *p_old = p_osd->p_vout;
+    p_osd->p_vout = p_vout;
+    p_osd->vout_changed = true;
+    vlc_mutex_unlock(&p_osd->lock);
+
+    if (p_old)
+        osd_vout_release(p_old);
+}
+
+void osd_detach_vout(osd_t *p_osd, vlc_object_t *p_filter)
+{
+    vout_thread_t *p_vout = osd_filter_vout(p_filter);
+    if (!p_vout)
+        return;
+
+    // another filter may have attached its video output since
+    vlc_mutex_lock(&p_osd->lock);
+    bool attached = p_osd->p_vout == p_vout;
+    if (attached) {
+        p_osd->p_vout = NULL;
+        p_osd->vout_changed = true;
+    }
+    vlc_mutex_unlock(&p_osd->lock);
+
+    if (attached)
+        osd_vout_release(p_vout);
+}
+
+void osd_vouts_changed(osd_t *p_osd)
+{
+    vlc_mutex_lock(&p_osd->lock);
+    // an attached video output isn't one of them
+    if (!p_osd->p_vout)
+        p_osd->vout_changed = true;
+    vlc_mutex_unlock(&p_osd->lock);
+}
+
+static void osd_send(osd_t *p_osd, intf_thread_t *p_intf_thread, const char *text, _vlc_tick_t now)
+{
+    vlc_mutex_lock(&p_osd->lock);
+    vout_thread_t *p_vout = p_osd->p_vout;
+    if (p_vout)
+        osd_vout_hold(p_vout);
+    vlc_mutex_unlock(&p_osd->lock);
+
+    if (p_vout) {
+        trace_record(TRACE_OSD, 0.f);
+        vout_OSDText(p_vout, VOUT_SPU_CHANNEL_OSD, VOUT_ALIGN_TOP | VOUT_ALIGN_RIGHT, INT64_MAX, text);
+        metrics_record(METRIC_OSD, _vlc_tick_now() - now);
+        osd_vout_release(p_vout);
+    } else {
+        display_speed_text(p_intf_thread, text);
+    }
+
+    strcpy(p_osd->shown, text);
+    p_osd->next = now + OSD_INTERVAL;
+    p_osd->sent++;
+}
+
+void osd_show(osd_t *p_osd, intf_thread_t *p_intf_thread, const char *text, _vlc_tick_t now)
+{
+    char copy[OSD_TEXT_SIZE];
+    strncpy(copy, text, sizeof(copy) - 1);
+    copy[sizeof(copy) - 1] = '\0';
+
+    vlc_mutex_lock(&p_osd->lock);
+    if (p_osd->vout_changed) {
+        p_osd->vout_changed = false;
+        p_osd->shown[0] = '\0';
+    }
+    vlc_mutex_unlock(&p_osd->lock);
+
+    if (p_osd->has_pending) {
+        // the pending text hasn't been shown, so it's simply replaced
+        p_osd->skipped++;
+        p_osd->has_pending = strcmp(copy, p_osd->shown) != 0;
+        if (p_osd->has_pending)
+            strcpy(p_osd->pending, copy);
+    } else if (!strcmp(copy, p_osd->shown)) {
+        p_osd->skipped++;
+    } else if (now < p_osd->next) {
+        strcpy(p_osd->pending, copy);
+        p_osd->has_pending = true;
+    } else {
+        osd_send(p_osd, p_intf_thread, copy, now);
+    }
+}
+
+void osd_poll(osd_t *p_osd, intf_thread_t *p_intf_thread, _vlc_tick_t now)
+{
+    if (!p_osd->has_pending || now < p_osd->next)
+        return;
+
+    p_osd->has_pending = false;
+    osd_send(p_osd, p_intf_thread, p_osd->pending, now);
+}
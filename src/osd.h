@@ -1,9 +1,54 @@
 #ifndef VLC_SPEED_HOLD_OSD_H
-#define VLC_SPEED_SPEED_HOLD_OSD_H
+#define VLC_SPEED_HOLD_OSD_H
 
 #include <vlc_common.h>
 #include <vlc_interface.h>
+#include <vlc_threads.h>
+
+#include "compat.h"
+
+#define OSD_TEXT_SIZE 32
+// Minimum time between two texts sent to the video output
+#define OSD_INTERVAL (CLOCK_FREQ / 20)
+
+// Owns the speed text of the OSD channel. Texts go to the video output the
+// filter is attached to, kept held between updates, or to every video output
+// of the player when there is none. A text identical to the one shown is
+// dropped, and texts coming faster than OSD_INTERVAL are coalesced into the
+// last one.
+typedef struct
+{
+    vlc_mutex_t lock;
+    vout_thread_t *p_vout; // protected by lock
+    bool vout_changed; // protected by lock, the new one shows no text yet
+
+    // owner thread only
+    char shown[OSD_TEXT_SIZE];
+    char pending[OSD_TEXT_SIZE];
+    bool has_pending;
+    _vlc_tick_t next;
+    uint64_t sent;
+    uint64_t skipped;
+} osd_t;
+
+void osd_init(osd_t *p_osd);
+void osd_clean(osd_t *p_osd);
+// From the video filter, targets its video output until it's detached
+void osd_attach_vout(osd_t *p_osd, vlc_object_t *p_filter);
+void osd_detach_vout(osd_t *p_osd, vlc_object_t *p_filter);
+// The video outputs of the player changed, the texts broadcast to them are
+// sent again even if identical
+void osd_vouts_changed(osd_t *p_osd);
+void osd_show(osd_t *p_osd, intf_thread_t *p_intf_thread, const char *text, _vlc_tick_t now);
+// Sends the coalesced text once OSD_INTERVAL elapsed
+void osd_poll(osd_t *p_osd, intf_thread_t *p_intf_thread, _vlc_tick_t now);
+
+static inline _vlc_tick_t osd_next_date(const osd_t *p_osd)
+{
+    return p_osd->has_pending ? p_osd->next : INT64_MAX;
+}
 
 void display_speed_text(intf_thread_t *p_intf_thread, const char* text);
+void format_speed_text(char *text, size_t size, float rate);
 
 #endif // VLC_SPEED_HOLD_OSD_H
\ No newline at end of file
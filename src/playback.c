@@ -29,3 +29,349 @@ void SetRate(intf_thread_t *p_intf_thread, float rate)
     }
 #endif
 }
+
+float GetRate(intf_thread_t *p_intf_thread)
+{
+    float rate = 1.0f;
+
+    if (!p_intf_thread) {
+        return rate;
+    }
+
+#if LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_intf_thread));
+    vlc_player_Lock(player);
+    rate = vlc_player_GetRate(player);
+    vlc_player_Unlock(player);
+#else
+    playlist_t* p_playlist = pl_Get(p_intf_thread);
+    input_thread_t *p_input = playlist_CurrentInput(p_playlist);
+    if(p_input)
+    {
+        rate = var_GetFloat(p_input, "rate");
+        vlc_object_release(p_input);
+    }
+#endif
+
+    return rate;
+}
+
+void PausePlay(intf_thread_t *p_intf_thread)
+{
+    if (!p_intf_thread) {
+        return;
+    }
+
+#if LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_intf_thread));
+    if (!player) {
+        return;
+    }
+    vlc_player_Lock(player);
+    int state = vlc_player_GetState(player);
+    state == VLC_PLAYER_STATE_PLAYING ? vlc_player_Pause(player) : vlc_player_Resume(player);
+    vlc_player_Unlock(player);
+#else
+    playlist_t* p_playlist = pl_Get(p_intf_thread);
+    if (!p_playlist) {
+        return;
+    }
+    playlist_status_t status = playlist_Status(p_playlist);
+    playlist_Control(p_playlist, status == PLAYLIST_RUNNING ? PLAYLIST_PAUSE : PLAYLIST_PLAY , 0);
+#endif
+}
+
+bool GetPictureStats(intf_thread_t *p_intf_thread, picture_stats_t *p_stats)
+{
+    bool ok = false;
+
+    if (!p_intf_thread) {
+        return ok;
+    }
+
+#if LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_intf_thread));
+    vlc_player_Lock(player);
+    const struct input_stats_t *p_input_stats = vlc_player_GetStatistics(player);
+    if (p_input_stats) {
+        p_stats->decoded = p_input_stats->i_decoded_video;
+        p_stats->displayed = p_input_stats->i_displayed_pictures;
+        p_stats->lost = p_input_stats->i_lost_pictures;
+        p_stats->late = p_input_stats->i_late_pictures;
+        ok = true;
+    }
+    vlc_player_Unlock(player);
+#else
+    playlist_t* p_playlist = pl_Get(p_intf_thread);
+    input_thread_t *p_input = playlist_CurrentInput(p_playlist);
+    if (!p_input) {
+        return ok;
+    }
+
+    input_item_t *p_item = input_GetItem(p_input);
+    vlc_mutex_lock(&p_item->lock);
+    if (p_item->p_stats) {
+        vlc_mutex_lock(&p_item->p_stats->lock);
+        p_stats->decoded = p_item->p_stats->i_decoded_video;
+        p_stats->displayed = p_item->p_stats->i_displayed_pictures;
+        p_stats->lost = p_item->p_stats->i_lost_pictures;
+        p_stats->late = 0;
+        vlc_mutex_unlock(&p_item->p_stats->lock);
+        ok = true;
+    }
+    vlc_mutex_unlock(&p_item->lock);
+    vlc_object_release(p_input);
+#endif
+
+    return ok;
+}
+
+bool GetIOStats(intf_thread_t *p_intf_thread, io_stats_t *p_stats)
+{
+    bool ok = false;
+
+    if (!p_intf_thread) {
+        return ok;
+    }
+
+#if LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_intf_thread));
+    vlc_player_Lock(player);
+    const struct input_stats_t *p_input_stats = vlc_player_GetStatistics(player);
+    if (p_input_stats) {
+        p_stats->read = p_input_stats->i_read_bytes;
+        p_stats->demuxed = p_input_stats->i_demux_read_bytes;
+        ok = true;
+    }
+    vlc_player_Unlock(player);
+#else
+    playlist_t* p_playlist = pl_Get(p_intf_thread);
+    input_thread_t *p_input = playlist_CurrentInput(p_playlist);
+    if (!p_input) {
+        return ok;
+    }
+
+    input_item_t *p_item = input_GetItem(p_input);
+    vlc_mutex_lock(&p_item->lock);
+    if (p_item->p_stats) {
+        vlc_mutex_lock(&p_item->p_stats->lock);
+        p_stats->read = p_item->p_stats->i_read_bytes;
+        p_stats->demuxed = p_item->p_stats->i_demux_read_bytes;
+        vlc_mutex_unlock(&p_item->p_stats->lock);
+        ok = true;
+    }
+    vlc_mutex_unlock(&p_item->lock);
+    vlc_object_release(p_input);
+#endif
+
+    return ok;
+}
+
+_vlc_tick_t GetTime(intf_thread_t *p_intf_thread)
+{
+    _vlc_tick_t time = -1;
+
+    if (!p_intf_thread) {
+        return time;
+    }
+
+#if LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_intf_thread));
+    vlc_player_Lock(player);
+    time = vlc_player_GetTime(player);
+    vlc_player_Unlock(player);
+    if (time == VLC_TICK_INVALID) {
+        time = -1;
+    }
+#else
+    playlist_t* p_playlist = pl_Get(p_intf_thread);
+    input_thread_t *p_input = playlist_CurrentInput(p_playlist);
+    if(p_input)
+    {
+        time = var_GetInteger(p_input, "time");
+        vlc_object_release(p_input);
+    }
+#endif
+
+    return time;
+}
+
+char *GetMediaURI(intf_thread_t *p_intf_thread)
+{
+    char *psz_uri = NULL;
+
+    if (!p_intf_thread) {
+        return psz_uri;
+    }
+
+#if LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_intf_thread));
+    vlc_player_Lock(player);
+    input_item_t *p_item = vlc_player_GetCurrentMedia(player);
+    if (p_item) {
+        psz_uri = input_item_GetURI(p_item);
+    }
+    vlc_player_Unlock(player);
+#else
+    playlist_t* p_playlist = pl_Get(p_intf_thread);
+    input_thread_t *p_input = playlist_CurrentInput(p_playlist);
+    if(p_input)
+    {
+        psz_uri = input_item_GetURI(input_GetItem(p_input));
+        vlc_object_release(p_input);
+    }
+#endif
+
+    return psz_uri;
+}
+
+void SeekTo(intf_thread_t *p_intf_thread, _vlc_tick_t time, bool fast)
+{
+    if (!p_intf_thread) {
+        return;
+    }
+
+#if LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_intf_thread));
+    vlc_player_Lock(player);
+    vlc_player_SeekByTime(player, time, fast ? VLC_PLAYER_SEEK_FAST : VLC_PLAYER_SEEK_PRECISE,
+                          VLC_PLAYER_WHENCE_ABSOLUTE);
+    vlc_player_Unlock(player);
+#else
+    // VLC 3 has no per-seek speed, fast seeks follow the "input-fast-seek"
+    // option
+    VLC_UNUSED(fast);
+    playlist_t* p_playlist = pl_Get(p_intf_thread);
+    input_thread_t *p_input = playlist_CurrentInput(p_playlist);
+    if(p_input)
+    {
+        var_SetInteger(p_input, "time", time);
+        vlc_object_release(p_input);
+    }
+#endif
+}
+
+void BypassAudio(intf_thread_t *p_intf_thread, audio_bypass_t bypass, audio_state_t *p_state)
+{
+    p_state->bypass = AUDIO_BYPASS_NONE;
+
+    if (!p_intf_thread) {
+        return;
+    }
+
+#if LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_intf_thread));
+    vlc_player_Lock(player);
+    if (bypass == AUDIO_BYPASS_MUTE && !vlc_player_aout_IsMuted(player)) {
+        if (vlc_player_aout_Mute(player, true) == VLC_SUCCESS)
+            p_state->bypass = bypass;
+    } else if (bypass == AUDIO_BYPASS_DISABLE && vlc_player_IsAudioEnabled(player)) {
+        // the player remembers the selected track and selects it again
+        vlc_player_SetAudioEnabled(player, false);
+        p_state->bypass = bypass;
+    }
+    vlc_player_Unlock(player);
+#else
+    playlist_t* p_playlist = pl_Get(p_intf_thread);
+    if (bypass == AUDIO_BYPASS_MUTE) {
+        // -1 if there is no audio output
+        if (playlist_MuteGet(p_playlist) == 0 && playlist_MuteSet(p_playlist, true) == VLC_SUCCESS)
+            p_state->bypass = bypass;
+    } else if (bypass == AUDIO_BYPASS_DISABLE) {
+        input_thread_t *p_input = playlist_CurrentInput(p_playlist);
+        if(p_input)
+        {
+            p_state->es_id = var_GetInteger(p_input, "audio-es");
+            if (p_state->es_id >= 0) {
+                var_SetInteger(p_input, "audio-es", -1);
+                p_state->bypass = bypass;
+            }
+            vlc_object_release(p_input);
+        }
+    }
+#endif
+}
+
+void RestoreAudio(intf_thread_t *p_intf_thread, audio_state_t *p_state)
+{
+    audio_bypass_t bypass = p_state->bypass;
+    p_state->bypass = AUDIO_BYPASS_NONE;
+
+    if (!p_intf_thread || bypass == AUDIO_BYPASS_NONE) {
+        return;
+    }
+
+#if LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_intf_thread));
+    vlc_player_Lock(player);
+    if (bypass == AUDIO_BYPASS_MUTE)
+        vlc_player_aout_Mute(player, false);
+    else
+        vlc_player_SetAudioEnabled(player, true);
+    vlc_player_Unlock(player);
+#else
+    playlist_t* p_playlist = pl_Get(p_intf_thread);
+    if (bypass == AUDIO_BYPASS_MUTE) {
+        playlist_MuteSet(p_playlist, false);
+    } else {
+        input_thread_t *p_input = playlist_CurrentInput(p_playlist);
+        if(p_input)
+        {
+            var_SetInteger(p_input, "audio-es", p_state->es_id);
+            vlc_object_release(p_input);
+        }
+    }
+#endif
+}
+
+// Values of VLC's avcodec-skiploopfilter (4: all) and avcodec-skip-frame
+// (1: non-reference) options, not libavcodec's AVDISCARD_* enum values
+#define FAST_SKIP_LOOP_FILTER 4
+#define FAST_SKIP_FRAME 1
+
+void SetFastDecoding(intf_thread_t *p_intf_thread, bool fast, decoder_state_t *p_state)
+{
+    if (!p_intf_thread || p_state->fast == fast) {
+        return;
+    }
+
+    // The decoder only reads these options when it is opened, and inherits
+    // them from its input. VLC 4.0 doesn't expose the input, so they are set
+    // on the instance for the time of the hold.
+#if LIBVLC_VERSION_MAJOR >= 4
+    vlc_object_t *p_obj = VLC_OBJECT(vlc_object_instance(p_intf_thread));
+#else
+    playlist_t* p_playlist = pl_Get(p_intf_thread);
+    input_thread_t *p_input = playlist_CurrentInput(p_playlist);
+    if (!p_input) {
+        return;
+    }
+    vlc_object_t *p_obj = VLC_OBJECT(p_input);
+#endif
+
+    if (fast) {
+        var_Create(p_obj, "avcodec-skiploopfilter", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
+        var_Create(p_obj, "avcodec-skip-frame", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
+        p_state->skip_loop_filter = var_GetInteger(p_obj, "avcodec-skiploopfilter");
+        p_state->skip_frame = var_GetInteger(p_obj, "avcodec-skip-frame");
+        var_SetInteger(p_obj, "avcodec-skiploopfilter", FAST_SKIP_LOOP_FILTER);
+        var_SetInteger(p_obj, "avcodec-skip-frame", FAST_SKIP_FRAME);
+    } else {
+        // a variable that existed before keeps its value once destroyed here
+        var_SetInteger(p_obj, "avcodec-skiploopfilter", p_state->skip_loop_filter);
+        var_SetInteger(p_obj, "avcodec-skip-frame", p_state->skip_frame);
+        var_Destroy(p_obj, "avcodec-skiploopfilter");
+        var_Destroy(p_obj, "avcodec-skip-frame");
+    }
+    p_state->fast = fast;
+
+#if LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_intf_thread));
+    vlc_player_Lock(player);
+    vlc_player_RestartTrackCategory(player, VIDEO_ES);
+    vlc_player_Unlock(player);
+#else
+    input_Control(p_input, INPUT_RESTART_ES, -VIDEO_ES);
+    vlc_object_release(p_input);
+#endif
+}
@@ -4,7 +4,59 @@
 #include <vlc_common.h>
 #include <vlc_interface.h>
 
+#include "compat.h"
+
+typedef struct
+{
+    int64_t decoded;
+    int64_t displayed;
+    int64_t lost;
+    int64_t late; // always 0 before VLC 4.0
+} picture_stats_t;
+
+typedef struct
+{
+    int64_t read; // bytes read by the access
+    int64_t demuxed; // bytes consumed by the demuxer
+} io_stats_t;
+
+typedef enum
+{
+    AUDIO_BYPASS_NONE,
+    AUDIO_BYPASS_MUTE,
+    AUDIO_BYPASS_DISABLE, // no audio decoding nor time-stretching at all
+} audio_bypass_t;
+
+// What BypassAudio() changed, so that RestoreAudio() only undoes that
+typedef struct
+{
+    audio_bypass_t bypass;
+    int64_t es_id; // audio track to select again, before VLC 4.0
+} audio_state_t;
+
+// Decoder options SetFastDecoding() overrode, restored when leaving it
+typedef struct
+{
+    bool fast;
+    int64_t skip_loop_filter;
+    int64_t skip_frame;
+} decoder_state_t;
+
 void SetRate(intf_thread_t *p_intf_thread, float rate);
+float GetRate(intf_thread_t *p_intf_thread);
+void PausePlay(intf_thread_t *p_intf_thread);
+bool GetPictureStats(intf_thread_t *p_intf_thread, picture_stats_t *p_stats);
+bool GetIOStats(intf_thread_t *p_intf_thread, io_stats_t *p_stats);
+// Media time of the current input, -1 if there is none
+_vlc_tick_t GetTime(intf_thread_t *p_intf_thread);
+// URI of the current media, to be freed, NULL if there is none
+char *GetMediaURI(intf_thread_t *p_intf_thread);
+void SeekTo(intf_thread_t *p_intf_thread, _vlc_tick_t time, bool fast);
+void BypassAudio(intf_thread_t *p_intf_thread, audio_bypass_t bypass, audio_state_t *p_state);
+void RestoreAudio(intf_thread_t *p_intf_thread, audio_state_t *p_state);
+// Restarts the video decoder without the deblocking filter and non-reference
+// frames, or back with the options it had before
+void SetFastDecoding(intf_thread_t *p_intf_thread, bool fast, decoder_state_t *p_state);
 
 
 #endif // VLC_SPEED_HOLD_PLAYBACK_H
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include <math.h>
+
+#include <vlc_common.h>
+
+#include "ramp.h"
+
+static float ramp_value(const ramp_t *p_ramp, float t)
+{
+    // An exponential curve gives every step the same ratio, which is how
+    // speed changes are perceived
+    if (p_ramp->params.curve == RAMP_CURVE_EXPONENTIAL && p_ramp->from > 0.f && p_ramp->to > 0.f)
+        return p_ramp->from * powf(p_ramp->to / p_ramp->from, t);
+
+    return p_ramp->from + (p_ramp->to - p_ramp->from) * t;
+}
+
+void ramp_start(ramp_t *p_ramp, float from, float to, const ramp_params_t *p_params, _vlc_tick_t now)
+{
+    p_ramp->active = true;
+    p_ramp->from = from;
+    p_ramp->to = to;
+    p_ramp->params = *p_params;
+    if (p_ramp->params.steps == 0 || p_ramp->params.duration <= 0)
+        p_ramp->params.steps = 1;
+    p_ramp->start = now;
+    p_ramp->step = 0;
+}
+
+static _vlc_tick_t ramp_interval(const ramp_t *p_ramp)
+{
+    return p_ramp->params.duration / p_ramp->params.steps;
+}
+
+_vlc_tick_t ramp_next_date(const ramp_t *p_ramp)
+{
+    return p_ramp->start + p_ramp->step * ramp_interval(p_ramp);
+}
+
+bool ramp_poll(ramp_t *p_ramp, _vlc_tick_t now, float *p_rate)
+{
+    if (!p_ramp->active)
+        return false;
+
+    unsigned due = p_ramp->params.steps;
+    _vlc_tick_t interval = ramp_interval(p_ramp);
+    if (interval > 0 && now - p_ramp->start < p_ramp->params.duration)
+        due = 1 + (now - p_ramp->start) / interval;
+    if (due > p_ramp->params.steps)
+        due = p_ramp->params.steps;
+
+    if (due <= p_ramp->step)
+        return false;
+
+    p_ramp->step = due;
+    if (due == p_ramp->params.steps) {
+        p_ramp->active = false;
+        *p_rate = p_ramp->to;
+    } else {
+        *p_rate = ramp_value(p_ramp, (float)due / p_ramp->params.steps);
+    }
+
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef VLC_SPEED_HOLD_RAMP_H
+#define VLC_SPEED_HOLD_RAMP_H
+
+#include <vlc_common.h>
+
+#include "compat.h"
+
+enum
+{
+    RAMP_CURVE_LINEAR,
+    RAMP_CURVE_EXPONENTIAL,
+};
+
+typedef struct
+{
+    _vlc_tick_t duration; // 0 switches the rate in a single step
+    unsigned steps;
+    int curve;
+} ramp_params_t;
+
+// Moves the rate from one value to another in evenly timed steps
+typedef struct
+{
+    bool active;
+    float from;
+    float to;
+    ramp_params_t params;
+    _vlc_tick_t start;
+    unsigned step; // last step returned by ramp_poll()
+} ramp_t;
+
+void ramp_start(ramp_t *p_ramp, float from, float to, const ramp_params_t *p_params, _vlc_tick_t now);
+
+// Returns true if a step is due and stores its rate. Steps that are overdue
+// are collapsed into the latest one. The ramp is inactive once its last step
+// has been returned.
+bool ramp_poll(ramp_t *p_ramp, _vlc_tick_t now, float *p_rate);
+
+// Date at which the next step becomes due
+_vlc_tick_t ramp_next_date(const ramp_t *p_ramp);
+
+#endif // VLC_SPEED_HOLD_RAMP_H
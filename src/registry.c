@@ -0,0 +1,148 @@
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_interface.h>
+#include <vlc_threads.h>
+
+#include "registry.h"
+#include "worker.h"
+
+static vlc_mutex_t registry_lock = VLC_STATIC_MUTEX;
+static intf_thread_t *registry_intf = NULL;
+static speed_hold_worker_t *registry_worker = NULL;
+static player_binding_t *registry_bindings = NULL;
+static player_binding_t *registry_pool = NULL;
+static size_t registry_pool_size = 0;
+
+// Takes the binding out of the bound list, with the lock held
+static void registry_unlink(player_binding_t *p_binding)
+{
+    player_binding_t **pp_binding = &registry_bindings;
+    while (*pp_binding && *pp_binding != p_binding)
+        pp_binding = &(*pp_binding)->p_next;
+    if (*pp_binding)
+        *pp_binding = p_binding->p_next;
+}
+
+int registry_add_interface(intf_thread_t *p_intf, speed_hold_worker_t *p_worker)
+{
+    int ret = VLC_EGENERIC;
+
+    vlc_mutex_lock(&registry_lock);
+    if (!registry_intf) {
+        registry_intf = p_intf;
+        registry_worker = p_worker;
+        ret = VLC_SUCCESS;
+    }
+    vlc_mutex_unlock(&registry_lock);
+
+    return ret;
+}
+
+size_t registry_remove_interface(intf_thread_t *p_intf)
+{
+    size_t count = 0;
+    player_binding_t *p_pool = NULL;
+
+    vlc_mutex_lock(&registry_lock);
+    if (registry_intf == p_intf) {
+        registry_intf = NULL;
+        registry_worker = NULL;
+        p_pool = registry_pool;
+        registry_pool = NULL;
+        registry_pool_size = 0;
+    }
+    for (player_binding_t *p_binding = registry_bindings; p_binding; p_binding = p_binding->p_next) {
+        if (p_binding->p_intf == p_intf)
+            count++;
+    }
+    vlc_mutex_unlock(&registry_lock);
+
+    // releasing detaches the queues, which takes the worker lock
+    while (p_pool) {
+        player_binding_t *p_next = p_pool->p_next;
+        p_pool->pf_release(p_pool);
+        p_pool = p_next;
+    }
+
+    return count;
+}
+
+int registry_add_filter(filter_t *p_filter, player_binding_t *p_binding)
+{
+    vlc_mutex_lock(&registry_lock);
+    if (!registry_intf) {
+        vlc_mutex_unlock(&registry_lock);
+        return VLC_EGENERIC;
+    }
+
+    // The queues are attached with the lock held, so the worker can't be
+    // destroyed in between
+    p_binding->p_mouse_queue = worker_attach_queue(registry_worker);
+    p_binding->p_timer_queue = worker_attach_queue(registry_worker);
+    p_binding->p_filter_queue = worker_attach_queue(registry_worker);
+    if (!p_binding->p_mouse_queue || !p_binding->p_timer_queue || !p_binding->p_filter_queue) {
+        vlc_mutex_unlock(&registry_lock);
+        if (p_binding->p_mouse_queue)
+            worker_detach_queue(p_binding->p_mouse_queue);
+        if (p_binding->p_timer_queue)
+            worker_detach_queue(p_binding->p_timer_queue);
+        if (p_binding->p_filter_queue)
+            worker_detach_queue(p_binding->p_filter_queue);
+        return VLC_ENOMEM;
+    }
+
+    p_binding->p_filter = p_filter;
+    p_binding->p_intf = registry_intf;
+    p_binding->p_worker = registry_worker;
+    p_binding->p_next = registry_bindings;
+    registry_bindings = p_binding;
+    vlc_mutex_unlock(&registry_lock);
+
+    return VLC_SUCCESS;
+}
+
+void registry_remove_filter(player_binding_t *p_binding)
+{
+    vlc_mutex_lock(&registry_lock);
+    registry_unlink(p_binding);
+    vlc_mutex_unlock(&registry_lock);
+
+    worker_detach_queue(p_binding->p_mouse_queue);
+    worker_detach_queue(p_binding->p_timer_queue);
+    worker_detach_queue(p_binding->p_filter_queue);
+}
+
+bool registry_park_filter(player_binding_t *p_binding)
+{
+    vlc_mutex_lock(&registry_lock);
+    if (registry_intf != p_binding->p_intf || registry_pool_size == REGISTRY_POOL_SIZE) {
+        vlc_mutex_unlock(&registry_lock);
+        return false;
+    }
+
+    registry_unlink(p_binding);
+    p_binding->p_filter = NULL;
+    p_binding->p_next = registry_pool;
+    registry_pool = p_binding;
+    registry_pool_size++;
+    vlc_mutex_unlock(&registry_lock);
+
+    return true;
+}
+
+player_binding_t *registry_unpark_filter(filter_t *p_filter)
+{
+    vlc_mutex_lock(&registry_lock);
+    player_binding_t *p_binding = registry_pool;
+    if (p_binding) {
+        registry_pool = p_binding->p_next;
+        registry_pool_size--;
+
+        p_binding->p_filter = p_filter;
+        p_binding->p_next = registry_bindings;
+        registry_bindings = p_binding;
+    }
+    vlc_mutex_unlock(&registry_lock);
+
+    return p_binding;
+}
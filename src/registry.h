@@ -0,0 +1,48 @@
+#ifndef VLC_SPEED_HOLD_REGISTRY_H
+#define VLC_SPEED_HOLD_REGISTRY_H
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_interface.h>
+
+#include "worker.h"
+
+// Ties a filter instance to the interface that owns its player. Every filter
+// gets its own queues, so any number of them can drive the player at once.
+typedef struct player_binding_t
+{
+    filter_t *p_filter;
+    intf_thread_t *p_intf;
+    speed_hold_worker_t *p_worker;
+    speed_hold_queue_t *p_mouse_queue;
+    speed_hold_queue_t *p_timer_queue;
+    speed_hold_queue_t *p_filter_queue; // pushed to by the video or audio filter callback
+    // Frees a parked binding along with the state around it
+    void (*pf_release)(struct player_binding_t *p_binding);
+
+    struct player_binding_t *p_next;
+} player_binding_t;
+
+// Closed filters parked for the next ones to take over
+#define REGISTRY_POOL_SIZE 2
+
+// Only one interface can be registered at a time
+int registry_add_interface(intf_thread_t *p_intf, speed_hold_worker_t *p_worker);
+// Releases the parked bindings, returns the number of filters still bound to
+// the interface
+size_t registry_remove_interface(intf_thread_t *p_intf);
+
+// Binds the filter to the registered interface and attaches its queues to
+// the worker. Fails if no interface is registered.
+int registry_add_filter(filter_t *p_filter, player_binding_t *p_binding);
+// Detaches the queues, the commands already pushed still get executed
+void registry_remove_filter(player_binding_t *p_binding);
+
+// Keeps the binding of a closing filter, queues included, for the next filter
+// to open. Returns false if the pool is full or the interface is gone, the
+// binding is then still bound and has to be removed.
+bool registry_park_filter(player_binding_t *p_binding);
+// Binds the filter to the most recently parked binding, NULL if there is none
+player_binding_t *registry_unpark_filter(filter_t *p_filter);
+
+#endif // VLC_SPEED_HOLD_REGISTRY_H
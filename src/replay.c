@@ -0,0 +1,226 @@
+#include <vlc_common.h>
+#include <vlc_fs.h>
+#include <vlc_threads.h>
+
+#include <inttypes.h>
+#include <stdatomic.h>
+
+#include "compat.h"
+#include "metrics.h"
+#include "replay.h"
+
+#define REPLAY_INITIAL_SIZE 1024
+
+struct replay_t
+{
+    vlc_object_t *p_obj;
+    replay_event_t *p_events;
+    uint32_t count;
+    _vlc_tick_t start;
+    replay_callback_t callback;
+    void *opaque;
+
+    vlc_thread_t thread;
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    bool quit;
+    atomic_bool running;
+};
+
+int replay_recorder_init(replay_recorder_t *p_recorder, _vlc_tick_t start)
+{
+    p_recorder->p_events = malloc(sizeof(replay_event_t) * REPLAY_INITIAL_SIZE);
+    if (!p_recorder->p_events)
+        return VLC_ENOMEM;
+
+    p_recorder->count = 0;
+    p_recorder->size = REPLAY_INITIAL_SIZE;
+    p_recorder->start = start;
+    return VLC_SUCCESS;
+}
+
+void replay_record(replay_recorder_t *p_recorder, const vlc_mouse_t *p_mouse)
+{
+    if (!p_recorder->p_events || p_recorder->count == REPLAY_MAX_EVENTS)
+        return;
+
+    if (p_recorder->count == p_recorder->size) {
+        replay_event_t *p_events = realloc(p_recorder->p_events, sizeof(replay_event_t) * p_recorder->size * 2);
+        if (!p_events)
+            return;
+        p_recorder->p_events = p_events;
+        p_recorder->size *= 2;
+    }
+
+    p_recorder->p_events[p_recorder->count++] = (replay_event_t) {
+        .time = _vlc_tick_now() - p_recorder->start,
+        .x = p_mouse->i_x,
+        .y = p_mouse->i_y,
+        .buttons = p_mouse->i_pressed,
+        .double_click = p_mouse->b_double_click,
+    };
+}
+
+bool replay_write(const replay_recorder_t *p_recorder, const char *psz_path)
+{
+    replay_header_t header = {
+        .magic = REPLAY_MAGIC,
+        .version = REPLAY_VERSION,
+        .count = p_recorder->count,
+        .clock_freq = CLOCK_FREQ,
+    };
+
+    FILE *p_file = vlc_fopen(psz_path, "wb");
+    bool ok = p_file
+           && fwrite(&header, sizeof(header), 1, p_file) == 1
+           && fwrite(p_recorder->p_events, sizeof(replay_event_t), p_recorder->count, p_file) == p_recorder->count;
+    if (p_file && fclose(p_file) != 0)
+        ok = false;
+
+    return ok;
+}
+
+void replay_recorder_clean(replay_recorder_t *p_recorder)
+{
+    free(p_recorder->p_events);
+    p_recorder->p_events = NULL;
+}
+
+static replay_event_t *replay_load(vlc_object_t *p_obj, const char *psz_path, uint32_t *p_count)
+{
+    FILE *p_file = vlc_fopen(psz_path, "rb");
+    if (!p_file) {
+        msg_Warn(p_obj, "[Speed Hold] Couldn't open the input recording %s", psz_path);
+        return NULL;
+    }
+
+    replay_header_t header;
+    replay_event_t *p_events = NULL;
+
+    if (fread(&header, sizeof(header), 1, p_file) != 1
+     || header.magic != REPLAY_MAGIC || header.version != REPLAY_VERSION
+     || header.clock_freq == 0 || header.count == 0 || header.count > REPLAY_MAX_EVENTS) {
+        msg_Warn(p_obj, "[Speed Hold] %s isn't an input recording of this version", psz_path);
+        goto out;
+    }
+
+    p_events = malloc(sizeof(replay_event_t) * header.count);
+    if (!p_events)
+        goto out;
+
+    if (fread(p_events, sizeof(replay_event_t), header.count, p_file) != header.count) {
+        msg_Warn(p_obj, "[Speed Hold] The input recording %s is truncated", psz_path);
+        free(p_events);
+        p_events = NULL;
+        goto out;
+    }
+
+    // recorded with another clock frequency
+    for (uint32_t i = 0; i < header.count; i++)
+        p_events[i].time = p_events[i].time * CLOCK_FREQ / header.clock_freq;
+    *p_count = header.count;
+
+out:
+    fclose(p_file);
+    return p_events;
+}
+
+static void *replay_thread(void *data)
+{
+    replay_t *p_replay = data;
+    vlc_mouse_t old;
+    _vlc_tick_t total_late = 0;
+    _vlc_tick_t max_late = 0;
+    uint32_t delivered = 0;
+
+    vlc_mouse_Init(&old);
+
+    vlc_mutex_lock(&p_replay->lock);
+    while (delivered < p_replay->count && !p_replay->quit) {
+        const replay_event_t *p_event = &p_replay->p_events[delivered];
+        _vlc_tick_t deadline = p_replay->start + p_event->time;
+
+        if (vlc_cond_timedwait(&p_replay->wait, &p_replay->lock, deadline) == 0)
+            continue; // stopping
+        vlc_mutex_unlock(&p_replay->lock);
+
+        _vlc_tick_t late = _vlc_tick_now() - deadline;
+        total_late += late;
+        if (late > max_late)
+            max_late = late;
+
+        vlc_mouse_t mouse = old;
+        mouse.i_x = p_event->x;
+        mouse.i_y = p_event->y;
+        mouse.i_pressed = p_event->buttons;
+        mouse.b_double_click = p_event->double_click;
+        p_replay->callback(p_replay->opaque, &old, &mouse);
+        old = mouse;
+        delivered++;
+
+        vlc_mutex_lock(&p_replay->lock);
+    }
+    vlc_mutex_unlock(&p_replay->lock);
+
+    atomic_store_explicit(&p_replay->running, false, memory_order_release);
+
+    msg_Dbg(p_replay->p_obj, "[Speed Hold] replayed %" PRIu32 " of %" PRIu32 " input events, "
+            "late avg %" PRId64 " us, max %" PRId64 " us", delivered, p_replay->count,
+            delivered ? (int64_t)(total_late / delivered) : 0, (int64_t)max_late);
+    metrics_log(p_replay->p_obj);
+
+    return NULL;
+}
+
+replay_t *replay_start(vlc_object_t *p_obj, const char *psz_path, _vlc_tick_t start,
+                       replay_callback_t callback, void *opaque)
+{
+    replay_t *p_replay = calloc(1, sizeof(replay_t));
+    if (!p_replay)
+        return NULL;
+
+    p_replay->p_events = replay_load(p_obj, psz_path, &p_replay->count);
+    if (!p_replay->p_events) {
+        free(p_replay);
+        return NULL;
+    }
+
+    p_replay->p_obj = p_obj;
+    p_replay->start = start;
+    p_replay->callback = callback;
+    p_replay->opaque = opaque;
+    vlc_mutex_init(&p_replay->lock);
+    vlc_cond_init(&p_replay->wait);
+    atomic_init(&p_replay->running, true);
+
+    if (_vlc_clone(&p_replay->thread, replay_thread, p_replay) != VLC_SUCCESS) {
+        _vlc_cond_destroy(&p_replay->wait);
+        _vlc_mutex_destroy(&p_replay->lock);
+        free(p_replay->p_events);
+        free(p_replay);
+        return NULL;
+    }
+
+    msg_Dbg(p_obj, "[Speed Hold] replaying %" PRIu32 " input events over %.1f s from %s", p_replay->count,
+            p_replay->p_events[p_replay->count - 1].time / (double)CLOCK_FREQ, psz_path);
+    return p_replay;
+}
+
+bool replay_is_running(replay_t *p_replay)
+{
+    return atomic_load_explicit(&p_replay->running, memory_order_acquire);
+}
+
+void replay_stop(replay_t *p_replay)
+{
+    vlc_mutex_lock(&p_replay->lock);
+    p_replay->quit = true;
+    vlc_cond_signal(&p_replay->wait);
+    vlc_mutex_unlock(&p_replay->lock);
+    vlc_join(p_replay->thread, NULL);
+
+    _vlc_cond_destroy(&p_replay->wait);
+    _vlc_mutex_destroy(&p_replay->lock);
+    free(p_replay->p_events);
+    free(p_replay);
+}
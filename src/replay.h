@@ -0,0 +1,63 @@
+#ifndef VLC_SPEED_HOLD_REPLAY_H
+#define VLC_SPEED_HOLD_REPLAY_H
+
+#include <vlc_common.h>
+#include <vlc_mouse.h>
+
+#include "compat.h"
+
+// Mouse sessions recorded by the filter and fed back to it later, so that
+// the same presses can be timed against other plugin or VLC versions.
+
+#define REPLAY_MAGIC 0x4e494853 // "SHIN"
+#define REPLAY_VERSION 1
+#define REPLAY_MAX_EVENTS 65536 // later events aren't recorded
+
+// File: a header followed by the events in chronological order, both in host
+// byte order
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t clock_freq; // time units per second
+} replay_header_t;
+
+typedef struct
+{
+    int64_t time; // since the filter opened
+    int32_t x;
+    int32_t y;
+    uint32_t buttons; // vlc_mouse_t.i_pressed
+    uint32_t double_click;
+} replay_event_t;
+
+typedef struct
+{
+    replay_event_t *p_events; // NULL when not recording
+    size_t count;
+    size_t size;
+    _vlc_tick_t start;
+} replay_recorder_t;
+
+int replay_recorder_init(replay_recorder_t *p_recorder, _vlc_tick_t start);
+// Only from the thread delivering the mouse events
+void replay_record(replay_recorder_t *p_recorder, const vlc_mouse_t *p_mouse);
+bool replay_write(const replay_recorder_t *p_recorder, const char *psz_path);
+void replay_recorder_clean(replay_recorder_t *p_recorder);
+
+typedef void (*replay_callback_t)(void *opaque, const vlc_mouse_t *p_old, const vlc_mouse_t *p_new);
+
+typedef struct replay_t replay_t;
+
+// Loads a recording and calls back with each of its events at the same time
+// after start as it was recorded, from a thread of its own. Logs how late the
+// events were delivered and the latency histograms once done.
+replay_t *replay_start(vlc_object_t *p_obj, const char *psz_path, _vlc_tick_t start,
+                       replay_callback_t callback, void *opaque);
+// False once every event was delivered, the real mouse events can be handled
+// again from then on
+bool replay_is_running(replay_t *p_replay);
+void replay_stop(replay_t *p_replay);
+
+#endif // VLC_SPEED_HOLD_REPLAY_H
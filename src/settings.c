@@ -0,0 +1,307 @@
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_configuration.h>
+#include <vlc_threads.h>
+#include <vlc_variables.h>
+
+#include "compat.h"
+#include "config.h"
+#include "playback.h"
+#include "settings.h"
+
+static const struct
+{
+    const char *name;
+    int type;
+} settings_vars[] =
+{
+    { MOUSE_BUTTON_CFG, VLC_VAR_INTEGER },
+    { REWIND_BUTTON_CFG, VLC_VAR_INTEGER },
+    { REWIND_RATE_CFG, VLC_VAR_FLOAT },
+    { ACCELERATION_RATE_CFG, VLC_VAR_FLOAT },
+    { EDGE_ACCELERATION_RATE_CFG, VLC_VAR_FLOAT },
+    { SKIM_RATE_CFG, VLC_VAR_FLOAT },
+    { HOLD_DELAY_CFG, VLC_VAR_INTEGER },
+    { DISPLAY_SPEED_CFG, VLC_VAR_BOOL },
+    { REGIONAL_SPEED_CFG, VLC_VAR_BOOL },
+    { ZONES_CFG, VLC_VAR_STRING },
+    { RAMP_DURATION_CFG, VLC_VAR_INTEGER },
+    { RAMP_STEPS_CFG, VLC_VAR_INTEGER },
+    { RAMP_CURVE_CFG, VLC_VAR_INTEGER },
+    { ADAPTIVE_RATE_CFG, VLC_VAR_BOOL },
+    { MAX_DROP_CFG, VLC_VAR_INTEGER },
+    { SPEED_CONTROL_CFG, VLC_VAR_BOOL },
+    { DRAG_SPEED_CFG, VLC_VAR_BOOL },
+    { DRAG_MIN_RATE_CFG, VLC_VAR_FLOAT },
+    { DRAG_MAX_RATE_CFG, VLC_VAR_FLOAT },
+    { DRAG_STEP_CFG, VLC_VAR_FLOAT },
+    { AUDIO_BYPASS_CFG, VLC_VAR_INTEGER },
+    { FAST_DECODING_RATE_CFG, VLC_VAR_FLOAT },
+    { AUTO_SPEED_CFG, VLC_VAR_BOOL },
+    { AUTO_SPEED_RATE_CFG, VLC_VAR_FLOAT },
+    { AUTO_SPEED_THRESHOLD_CFG, VLC_VAR_FLOAT },
+    { AUTO_SPEED_INTERVAL_CFG, VLC_VAR_INTEGER },
+    { SILENCE_RATE_CFG, VLC_VAR_FLOAT },
+    { SILENCE_LEVEL_CFG, VLC_VAR_INTEGER },
+    { SILENCE_DURATION_CFG, VLC_VAR_INTEGER },
+};
+
+static int settings_set(speed_hold_settings_t *p_settings, const char *name, vlc_value_t val)
+{
+    if (!strcmp(name, MOUSE_BUTTON_CFG)) {
+        // without a button no press would ever be followed
+        p_settings->mouse_button = val.i_int > 0 ? val.i_int : MOUSE_BUTTON_DEFAULT;
+    } else if (!strcmp(name, REWIND_BUTTON_CFG)) {
+        p_settings->rewind_button = val.i_int > 0 ? val.i_int : 0;
+    } else if (!strcmp(name, REWIND_RATE_CFG)) {
+        p_settings->rewind_rate = val.f_float > 0.f ? val.f_float : REWIND_RATE_DEFAULT;
+    } else if (!strcmp(name, ACCELERATION_RATE_CFG)) {
+        p_settings->rate = val.f_float;
+    } else if (!strcmp(name, EDGE_ACCELERATION_RATE_CFG)) {
+        p_settings->edge_rate = val.f_float;
+    } else if (!strcmp(name, SKIM_RATE_CFG)) {
+        p_settings->skim_rate = val.f_float;
+    } else if (!strcmp(name, HOLD_DELAY_CFG)) {
+        p_settings->hold_delay = val.i_int;
+    } else if (!strcmp(name, DISPLAY_SPEED_CFG)) {
+        p_settings->display_speed = val.b_bool;
+    } else if (!strcmp(name, REGIONAL_SPEED_CFG)) {
+        p_settings->regional_speed = val.b_bool;
+    } else if (!strcmp(name, ZONES_CFG)) {
+        zone_map_t zones;
+        if (zone_map_parse(&zones, val.psz_string ? val.psz_string : "") != VLC_SUCCESS)
+            return VLC_EGENERIC;
+        p_settings->zones = zones;
+    } else if (!strcmp(name, RAMP_DURATION_CFG)) {
+        p_settings->ramp.duration = val.i_int * 1000;
+    } else if (!strcmp(name, RAMP_STEPS_CFG)) {
+        p_settings->ramp.steps = val.i_int;
+    } else if (!strcmp(name, RAMP_CURVE_CFG)) {
+        p_settings->ramp.curve = val.i_int;
+    } else if (!strcmp(name, ADAPTIVE_RATE_CFG)) {
+        p_settings->adaptive_rate = val.b_bool;
+    } else if (!strcmp(name, MAX_DROP_CFG)) {
+        p_settings->max_drop = val.i_int;
+    } else if (!strcmp(name, SPEED_CONTROL_CFG)) {
+        p_settings->speed_control = val.b_bool;
+    } else if (!strcmp(name, DRAG_SPEED_CFG)) {
+        p_settings->drag_speed = val.b_bool;
+    } else if (!strcmp(name, DRAG_MIN_RATE_CFG)) {
+        p_settings->drag_min_rate = val.f_float;
+    } else if (!strcmp(name, DRAG_MAX_RATE_CFG)) {
+        p_settings->drag_max_rate = val.f_float;
+    } else if (!strcmp(name, DRAG_STEP_CFG)) {
+        p_settings->drag_step = val.f_float;
+    } else if (!strcmp(name, AUDIO_BYPASS_CFG)) {
+        if (val.i_int < AUDIO_BYPASS_NONE || val.i_int > AUDIO_BYPASS_DISABLE)
+            return VLC_EGENERIC;
+        p_settings->audio_bypass = val.i_int;
+    } else if (!strcmp(name, FAST_DECODING_RATE_CFG)) {
+        p_settings->fast_decoding_rate = val.f_float;
+    } else if (!strcmp(name, AUTO_SPEED_CFG)) {
+        p_settings->auto_speed = val.b_bool;
+    } else if (!strcmp(name, AUTO_SPEED_RATE_CFG)) {
+        p_settings->auto_speed_rate = val.f_float;
+    } else if (!strcmp(name, AUTO_SPEED_THRESHOLD_CFG)) {
+        p_settings->auto_speed_threshold = val.f_float;
+    } else if (!strcmp(name, AUTO_SPEED_INTERVAL_CFG)) {
+        p_settings->auto_speed_interval = val.i_int;
+    } else if (!strcmp(name, SILENCE_RATE_CFG)) {
+        p_settings->silence_rate = val.f_float;
+    } else if (!strcmp(name, SILENCE_LEVEL_CFG)) {
+        p_settings->silence_level = val.i_int;
+    } else if (!strcmp(name, SILENCE_DURATION_CFG)) {
+        p_settings->silence_duration = val.i_int;
+    }
+
+    return VLC_SUCCESS;
+}
+
+// Frees the retired snapshots, unless a reader might still be holding one of
+// them. Called with the lock held, after a new snapshot was swapped in.
+static void settings_reclaim(speed_hold_settings_cache_t *p_cache)
+{
+    if (atomic_load(&p_cache->readers) > 0)
+        return;
+
+    while (p_cache->p_retired) {
+        speed_hold_settings_t *p_next = p_cache->p_retired->p_retired;
+        free(p_cache->p_retired);
+        p_cache->p_retired = p_next;
+    }
+}
+
+static int settings_callback(vlc_object_t *p_this, const char *name,
+                             vlc_value_t oldval, vlc_value_t newval, void *data)
+{
+    VLC_UNUSED(oldval);
+    speed_hold_settings_cache_t *p_cache = data;
+
+    speed_hold_settings_t *p_settings = malloc(sizeof(speed_hold_settings_t));
+    if (!p_settings)
+        return VLC_ENOMEM;
+
+    vlc_mutex_lock(&p_cache->lock);
+    speed_hold_settings_t *p_old = atomic_load_explicit(&p_cache->p_current, memory_order_relaxed);
+    *p_settings = *p_old;
+    if (settings_set(p_settings, name, newval) != VLC_SUCCESS) {
+        vlc_mutex_unlock(&p_cache->lock);
+        free(p_settings);
+        msg_Warn(p_this, "[Speed Hold] invalid %s, keeping the previous value", name);
+        return VLC_EGENERIC;
+    }
+    p_settings->generation++;
+    p_settings->p_retired = NULL;
+    atomic_store(&p_cache->p_current, p_settings);
+    p_old->p_retired = p_cache->p_retired;
+    p_cache->p_retired = p_old;
+    settings_reclaim(p_cache);
+    vlc_mutex_unlock(&p_cache->lock);
+
+    msg_Dbg(p_this, "[Speed Hold] %s changed", name);
+
+    return VLC_SUCCESS;
+}
+
+int settings_init(speed_hold_settings_cache_t *p_cache, vlc_object_t *p_obj)
+{
+    speed_hold_settings_t *p_settings = calloc(1, sizeof(speed_hold_settings_t));
+    if (!p_settings)
+        return VLC_ENOMEM;
+
+    // Shared by every filter and reachable from Lua, e.g.
+    // vlc.var.set(vlc.object.libvlc(), "speed-hold-rate", 4)
+    p_cache->p_obj = _vlc_object_instance(p_obj);
+    vlc_mutex_init(&p_cache->lock);
+    atomic_init(&p_cache->readers, 0);
+    p_cache->p_retired = NULL;
+
+    for (size_t i = 0; i < ARRAY_SIZE(settings_vars); i++) {
+        vlc_value_t val;
+        var_Create(p_cache->p_obj, settings_vars[i].name, settings_vars[i].type | VLC_VAR_DOINHERIT | VLC_VAR_ISCOMMAND);
+        var_Get(p_cache->p_obj, settings_vars[i].name, &val);
+        if (settings_set(p_settings, settings_vars[i].name, val) != VLC_SUCCESS)
+            msg_Warn(p_obj, "[Speed Hold] invalid %s, ignoring it", settings_vars[i].name);
+        if (settings_vars[i].type == VLC_VAR_STRING)
+            free(val.psz_string);
+    }
+    p_settings->generation = 1;
+    atomic_init(&p_cache->p_current, p_settings);
+
+    for (size_t i = 0; i < ARRAY_SIZE(settings_vars); i++)
+        var_AddCallback(p_cache->p_obj, settings_vars[i].name, settings_callback, p_cache);
+
+    return VLC_SUCCESS;
+}
+
+void settings_clean(speed_hold_settings_cache_t *p_cache)
+{
+    // waits for the callbacks running on other threads
+    for (size_t i = 0; i < ARRAY_SIZE(settings_vars); i++) {
+        var_DelCallback(p_cache->p_obj, settings_vars[i].name, settings_callback, p_cache);
+        var_Destroy(p_cache->p_obj, settings_vars[i].name);
+    }
+
+    speed_hold_settings_t *p_settings = atomic_load(&p_cache->p_current);
+    p_settings->p_retired = p_cache->p_retired;
+    while (p_settings) {
+        speed_hold_settings_t *p_retired = p_settings->p_retired;
+        free(p_settings);
+        p_settings = p_retired;
+    }
+    _vlc_mutex_destroy(&p_cache->lock);
+}
+
+static vlc_value_t settings_read_config(vlc_object_t *p_obj, size_t index)
+{
+    vlc_value_t val;
+    switch (settings_vars[index].type) {
+        case VLC_VAR_BOOL:
+            val.b_bool = _config_GetInt(p_obj, settings_vars[index].name) != 0;
+            break;
+        case VLC_VAR_INTEGER:
+            val.i_int = _config_GetInt(p_obj, settings_vars[index].name);
+            break;
+        case VLC_VAR_FLOAT:
+            val.f_float = _config_GetFloat(p_obj, settings_vars[index].name);
+            break;
+        default:
+            val.psz_string = _config_GetPsz(p_obj, settings_vars[index].name);
+            break;
+    }
+    return val;
+}
+
+static bool settings_value_equal(size_t index, vlc_value_t a, vlc_value_t b)
+{
+    switch (settings_vars[index].type) {
+        case VLC_VAR_BOOL:
+            return a.b_bool == b.b_bool;
+        case VLC_VAR_INTEGER:
+            return a.i_int == b.i_int;
+        case VLC_VAR_FLOAT:
+            return a.f_float == b.f_float;
+        default:
+            return !strcmp(a.psz_string ? a.psz_string : "", b.psz_string ? b.psz_string : "");
+    }
+}
+
+// Only what changed in the configuration is set, so a value set from Lua
+// stays until the preferences change that option again
+static void settings_watch_callback(void *data)
+{
+    speed_hold_settings_watch_t *p_watch = data;
+
+    for (size_t i = 0; i < ARRAY_SIZE(settings_vars); i++) {
+        vlc_value_t val = settings_read_config(p_watch->p_obj, i);
+        if (settings_value_equal(i, val, p_watch->p_values[i])) {
+            if (settings_vars[i].type == VLC_VAR_STRING)
+                free(val.psz_string);
+            continue;
+        }
+
+        msg_Dbg(p_watch->p_obj, "[Speed Hold] %s changed in the preferences", settings_vars[i].name);
+        if (settings_vars[i].type == VLC_VAR_STRING)
+            free(p_watch->p_values[i].psz_string);
+        p_watch->p_values[i] = val;
+        var_Set(p_watch->p_obj, settings_vars[i].name, val);
+    }
+}
+
+static void settings_watch_clean(speed_hold_settings_watch_t *p_watch)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(settings_vars); i++) {
+        if (settings_vars[i].type == VLC_VAR_STRING)
+            free(p_watch->p_values[i].psz_string);
+        var_Destroy(p_watch->p_obj, settings_vars[i].name);
+    }
+    free(p_watch->p_values);
+}
+
+int settings_watch_start(speed_hold_settings_watch_t *p_watch, vlc_object_t *p_obj)
+{
+    p_watch->p_obj = _vlc_object_instance(p_obj);
+    p_watch->p_values = malloc(ARRAY_SIZE(settings_vars) * sizeof(vlc_value_t));
+    if (!p_watch->p_values)
+        return VLC_ENOMEM;
+
+    // the variables keep what Lua set between two media, when no filter is open
+    for (size_t i = 0; i < ARRAY_SIZE(settings_vars); i++) {
+        var_Create(p_watch->p_obj, settings_vars[i].name, settings_vars[i].type | VLC_VAR_DOINHERIT | VLC_VAR_ISCOMMAND);
+        p_watch->p_values[i] = settings_read_config(p_watch->p_obj, i);
+    }
+
+    if (vlc_timer_create(&p_watch->timer, settings_watch_callback, p_watch) != VLC_SUCCESS) {
+        settings_watch_clean(p_watch);
+        return VLC_EGENERIC;
+    }
+    vlc_timer_schedule(p_watch->timer, false, SETTINGS_WATCH_INTERVAL, SETTINGS_WATCH_INTERVAL);
+
+    return VLC_SUCCESS;
+}
+
+void settings_watch_stop(speed_hold_settings_watch_t *p_watch)
+{
+    vlc_timer_destroy(p_watch->timer);
+    settings_watch_clean(p_watch);
+}
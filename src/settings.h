@@ -0,0 +1,91 @@
+#ifndef VLC_SPEED_HOLD_SETTINGS_H
+#define VLC_SPEED_HOLD_SETTINGS_H
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_threads.h>
+
+#include "ramp.h"
+#include "zones.h"
+
+// Immutable snapshot of the plugin options, read by the hot paths without
+// going through var_Inherit*(). The options are variables of the instance,
+// which Lua and the other interfaces can set. A change builds a new snapshot
+// and swaps it in, the older ones are freed by the next change that finds no
+// reader holding a snapshot.
+typedef struct speed_hold_settings_t
+{
+    int64_t mouse_button; // vlc_mouse_t.i_pressed mask
+    int64_t rewind_button; // mask, 0 if none
+    float rewind_rate;
+    float rate;
+    float edge_rate;
+    float skim_rate;
+    int64_t hold_delay; // ms
+    bool display_speed;
+    bool regional_speed;
+    zone_map_t zones; // empty to use the edge rate
+    ramp_params_t ramp;
+    bool adaptive_rate;
+    int64_t max_drop; // %
+    bool speed_control;
+    bool drag_speed;
+    float drag_min_rate;
+    float drag_max_rate;
+    float drag_step;
+    int64_t audio_bypass; // audio_bypass_t
+    float fast_decoding_rate;
+    bool auto_speed;
+    float auto_speed_rate;
+    float auto_speed_threshold;
+    int64_t auto_speed_interval;
+    float silence_rate;
+    int64_t silence_level; // dBFS
+    int64_t silence_duration; // ms
+
+    unsigned generation; // of the change that built it, from 1
+    struct speed_hold_settings_t *p_retired; // next one to free, once retired
+} speed_hold_settings_t;
+
+typedef struct
+{
+    vlc_object_t *p_obj; // the instance, holding the variables
+    vlc_mutex_t lock;
+    _Atomic(speed_hold_settings_t *) p_current;
+    atomic_uint readers;
+    speed_hold_settings_t *p_retired; // protected by lock
+} speed_hold_settings_cache_t;
+
+int settings_init(speed_hold_settings_cache_t *p_cache, vlc_object_t *p_obj);
+void settings_clean(speed_hold_settings_cache_t *p_cache);
+
+// The snapshot stays valid until settings_release(), which is to be called
+// before returning to VLC. Never waits.
+static inline const speed_hold_settings_t *settings_hold(speed_hold_settings_cache_t *p_cache)
+{
+    // ordered with the swap of the snapshot, a change either sees the reader
+    // or the reader sees the new snapshot
+    atomic_fetch_add(&p_cache->readers, 1);
+    return atomic_load(&p_cache->p_current);
+}
+
+static inline void settings_release(speed_hold_settings_cache_t *p_cache)
+{
+    atomic_fetch_sub_explicit(&p_cache->readers, 1, memory_order_release);
+}
+
+// The preferences only write the configuration, which the interface reads
+// again every SETTINGS_WATCH_INTERVAL to set the variables it changed
+#define SETTINGS_WATCH_INTERVAL CLOCK_FREQ
+
+typedef struct
+{
+    vlc_object_t *p_obj; // the instance
+    vlc_timer_t timer;
+    vlc_value_t *p_values; // last read from the configuration, timer only
+} speed_hold_settings_watch_t;
+
+int settings_watch_start(speed_hold_settings_watch_t *p_watch, vlc_object_t *p_obj);
+void settings_watch_stop(speed_hold_settings_watch_t *p_watch);
+
+#endif // VLC_SPEED_HOLD_SETTINGS_H
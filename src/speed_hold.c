@@ -26,6 +26,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <inttypes.h>
+#include <math.h>
 
 #ifdef HAVE_CONFIG_H
 # include "config.h"
@@ -41,9 +42,12 @@
 # define VLC_MODULE_COPYRIGHT VERSION_COPYRIGHT
 #endif
 
+#include <vlc_aout.h>
 #include <vlc_atomic.h>
+#include <vlc_block.h>
 #include <vlc_common.h>
 #include <vlc_filter.h>
+#include <vlc_fourcc.h>
 #include <vlc_input.h>
 #include <vlc_messages.h>
 #include <vlc_mouse.h>
@@ -61,9 +65,21 @@
 #include <vlc_config.h>
 #include <vlc_spu.h>
 
+#include "capture.h"
 #include "config.h"
+#include "group.h"
+#include "history.h"
+#include "hold.h"
+#include "level.h"
+#include "metrics.h"
+#include "motion.h"
 #include "osd.h"
-#include "playback.h"
+#include "registry.h"
+#include "replay.h"
+#include "settings.h"
+#include "trace.h"
+#include "worker.h"
+#include "zones.h"
 
 #if LIBVLC_VERSION_MAJOR == 2 && LIBVLC_VERSION_MINOR == 1
 # include "third_party/vlc/2.1.0/include/vlc_interface.h"
@@ -77,26 +93,109 @@
 
 #define UNUSED(x) (void)(x)
 
+// How long a hold survives its filter closing, for the next item's filter to
+// take it over
+#define FILTER_CARRY_TIME (3 * CLOCK_FREQ)
+
+// Consecutive still samples needed before auto speed raises the rate
+#define AUTO_SPEED_STILL_SAMPLES 3
+
+// Audio is judged over windows of at least this long
+#define SILENCE_WINDOW (CLOCK_FREQ / 20)
+// A window whose peak is this much above the silence level isn't silent,
+// whatever its RMS level
+#define SILENCE_PEAK_MARGIN 20.f
+
 static int OpenFilter(vlc_object_t *);
 static void CloseFilter(vlc_object_t *);
+static int OpenAudioFilter(vlc_object_t *);
+static void CloseAudioFilter(vlc_object_t *);
 static int OpenInterface(vlc_object_t *);
 static void CloseInterface(vlc_object_t *);
 static void timer_callback(void* data);
-static void pause_play(void);
 
-static intf_thread_t *p_interface_thread = NULL;
-static vlc_timer_t timer;
-static bool timer_initialized = false;
-static atomic_bool timer_scheduled;
+struct intf_sys_t
+{
+    speed_hold_worker_t *p_worker;
+    // sets the option variables to what the preferences save
+    speed_hold_settings_watch_t settings_watch;
+    bool settings_watched;
+    // mouse capture mode, driving the state a video filter would otherwise own
+    capture_t *p_capture;
+    filter_sys_t *p_capture_sys;
+    // applies the holds of the other sync group members
+    speed_hold_queue_t *p_group_queue;
+    intf_thread_t *p_intf;
+    // rate before the group's hold, group thread only
+    bool group_held;
+    float group_rate;
+};
 
 struct filter_sys_t
 {
+    // the video filter, or the interface when capturing the mouse from it
+    vlc_object_t *p_obj;
+    // size of the video the mouse coordinates refer to, 0 if unknown
+    unsigned width;
+    unsigned height;
     float original_rate;
-    bool rate_changed_by_mouse;
+    speed_hold_settings_cache_t settings;
+    hold_t hold;
     int mouse_x;
     int mouse_y;
+    // no filter reads the rate to restore when an item opens
+    bool rate_on_fire;
+    // the hold started on a previous filter, whose video output saw the press
+    bool hold_carried;
+    // button of the press in progress, which skims backwards on the rewind one
+    int hold_button;
+    bool hold_rewind;
+    // written by mouse() before the timer is scheduled
+    _vlc_tick_t pressed;
+    _vlc_tick_t hold_deadline;
+    // written by the timer before hold_fired()
+    float hold_rate;
+    bool hold_skimming;
+    long drag_step; // last quantized rate pushed while dragging
+    // speed memory of the current media, whose key is 0 when it's off
+    uint64_t media_key;
+    float memory_rate; // replaces the acceleration rate when set
+    // regional speed lookup, only touched by the timer once opened
+    zone_lut_t zones;
+    unsigned zones_generation; // of the settings the LUT was built from, 0 if none
+    // auto speed, only touched by filter() once opened
+    motion_t motion;
+    bool auto_active;
+    unsigned auto_cancels; // of the worker when the rate was pushed
+    unsigned auto_pictures;
+    unsigned auto_still;
+    uint64_t auto_samples;
+    _vlc_tick_t auto_total_time;
+    _vlc_tick_t auto_max_time;
+    vlc_timer_t timer;
+    // recording written on close, and the replay fed to mouse_event()
+    replay_recorder_t recorder;
+    replay_t *p_replay;
+    // Owns this instance's queues. mouse() and the timer run on different
+    // threads, each gets its own single-producer queue.
+    player_binding_t player;
 };
 
+typedef struct
+{
+    speed_hold_settings_cache_t settings;
+    level_t level;
+    size_t window_frames;
+    uint64_t silent_frames;
+    bool silence_active;
+    unsigned auto_cancels; // of the worker when the rate was pushed
+    uint64_t blocks;
+    _vlc_tick_t total_time;
+    _vlc_tick_t max_time;
+    // only its filter queue is used
+    player_binding_t player;
+} audio_filter_sys_t;
+
 // VLC 4.0 removed the advanced flag in 3716a7da5ba8dc30dbd752227c6a893c71a7495b
 #if LIBVLC_VERSION_MAJOR >= 4
 # define _add_bool(name, v, text, longtext, advc) \
@@ -107,13 +206,28 @@ struct filter_sys_t
     add_integer_with_range(name, value, i_min, i_max, text, longtext)
 # define _add_float(name, value, text, longtext, advc) \
     add_float(name, value, text, longtext)
+# define _add_string(name, value, text, longtext, advc) \
+    add_string(name, value, text, longtext)
 #else
 # define _add_bool add_bool
 # define _add_integer add_integer
 # define _add_integer_with_range add_integer_with_range
 # define _add_float add_float
+# define _add_string add_string
 #endif
 
+static const int ramp_curve_values[] = { RAMP_CURVE_LINEAR, RAMP_CURVE_EXPONENTIAL };
+static const char *const ramp_curve_texts[] = { N_("Linear"), N_("Exponential") };
+
+static const int mouse_button_values[] = { 1, 2, 4 };
+static const char *const mouse_button_texts[] = { N_("Left"), N_("Middle"), N_("Right") };
+
+static const int rewind_button_values[] = { 0, 1, 2, 4 };
+static const char *const rewind_button_texts[] = { N_("None"), N_("Left"), N_("Middle"), N_("Right") };
+
+static const int audio_bypass_values[] = { AUDIO_BYPASS_NONE, AUDIO_BYPASS_MUTE, AUDIO_BYPASS_DISABLE };
+static const char *const audio_bypass_texts[] = { N_("Keep"), N_("Mute"), N_("Disable") };
+
 // VLC 4.0 made set_help() render as a plain text, introducing set_html_help()
 // for HTML
 // faf8b85ac3e55bc95cfd80f914e8537c47d2c1a5
@@ -155,23 +269,156 @@ vlc_module_begin()
                  "Homepage: <a href=\"" VERSION_HOMEPAGE "\">" VERSION_HOMEPAGE "</a>"
                  "</p>"))
     set_section(N_("General"), NULL)
+    _add_integer(MOUSE_BUTTON_CFG, MOUSE_BUTTON_DEFAULT,
+                 N_("Mouse button"),
+                 N_("Button to click to pause/play and hold to accelerate."), false)
+        change_integer_list(mouse_button_values, mouse_button_texts)
     _add_float(ACCELERATION_RATE_CFG, ACCELERATION_RATE_DEFAULT,
               N_("Acceleration rate"),
               N_("Playback rate to set when acceleration is active."), false)
+    _add_float(SKIM_RATE_CFG, SKIM_RATE_DEFAULT,
+              N_("Skim rate threshold"),
+              N_("From this acceleration rate on, the playback rate is left alone and the "
+                 "video jumps from keyframe to keyframe instead, which doesn't require "
+                 "decoding every frame. 0 disables skimming."), false)
+    _add_integer(REWIND_BUTTON_CFG, REWIND_BUTTON_DEFAULT,
+                 N_("Rewind button"),
+                 N_("Button to hold to skim backwards. VLC can't play backwards, so the video "
+                    "jumps back from keyframe to keyframe, more smoothly once they have been "
+                    "skimmed over once."), false)
+        change_integer_list(rewind_button_values, rewind_button_texts)
+    _add_float(REWIND_RATE_CFG, REWIND_RATE_DEFAULT,
+               N_("Rewind rate"),
+               N_("How many times faster than real time to skim backwards, 2 to 8 work "
+                  "best."), false)
     _add_integer_with_range(HOLD_DELAY_CFG, HOLD_DELAY_DEFAULT, 100, 2000,
                             N_("Hold delay (ms)"),
                             N_("Time to hold the mouse button to trigger acceleration."), false)
     _add_bool(DISPLAY_SPEED_CFG, DISPLAY_SPEED_DEFAULT,
               N_("Display speed text"),
               N_("Show the current speed on screen when accelerating."), false)
+    _add_integer(AUDIO_BYPASS_CFG, AUDIO_BYPASS_DEFAULT,
+                 N_("Audio while accelerating"),
+                 N_("What to do with the audio during a hold. Disabling it also stops the "
+                    "audio decoding and time-stretching, which are costly at high rates. "
+                    "The previous audio state is restored on release."), false)
+        change_integer_list(audio_bypass_values, audio_bypass_texts)
+    _add_float(FAST_DECODING_RATE_CFG, FAST_DECODING_RATE_DEFAULT,
+              N_("Fast decoding rate threshold"),
+              N_("From this acceleration rate on, the video decoder skips the deblocking "
+                 "filter and non-reference frames during the hold, which allows higher rates "
+                 "on slow machines. The decoder is restarted to switch, so the picture may "
+                 "freeze until the next keyframe. 0 disables it."), true)
     _add_bool(REGIONAL_SPEED_CFG, REGIONAL_SPEED_DEFAULT,
               N_("Enable regional speed control"),
               N_("Enable different speed controls based on mouse position."), false)
+    _add_bool(SPEED_MEMORY_CFG, SPEED_MEMORY_DEFAULT,
+              N_("Remember the speed of each media"),
+              N_("Play each media again at the rate it was last played at, and hold it at "
+                 "the rate its last hold ended at. Regional speed zones aren't remembered. "
+                 "The rates are kept in a file of the VLC user data directory."), false)
+    _add_string(SYNC_GROUP_CFG, SYNC_GROUP_DEFAULT,
+                N_("Sync group"),
+                N_("VLC instances of this computer given the same group name apply each "
+                   "other's holds, e.g. to review several angles of the same footage. "
+                   "Letters, digits, - and _ only."), true)
+    _add_bool(MOUSE_CAPTURE_CFG, MOUSE_CAPTURE_DEFAULT,
+              N_("Capture the mouse from the interface"),
+              N_("Follow the mouse from the interface instead of the video filter, which "
+                 "then stays out of the video path and leaves hardware decoded pictures "
+                 "in video memory. Auto speed, recording and replay need the filter. "
+                 "VLC has to be restarted to switch."), true)
     set_section(N_("Regional Speed"), NULL)
     _add_float(EDGE_ACCELERATION_RATE_CFG, EDGE_ACCELERATION_RATE_DEFAULT,
               N_("Edge acceleration rate"),
               N_("Playback rate for the edges of the screen (first and last 20%). "
-                 "Only used when regional speed control is enabled."), true)
+                 "Only used when regional speed control is enabled and no zones are set."), true)
+    _add_string(ZONES_CFG, ZONES_DEFAULT,
+                N_("Speed zones"),
+                N_("Comma separated list of screen zones with their playback rate, as "
+                   "<x range>[/<y range>]:<rate>, a range being <start>-<end>% or * for "
+                   "the whole width or height. The first zone containing the press is "
+                   "used, the acceleration rate applies outside of them. "
+                   "E.g. 0-10%:8x,10-30%:3x,70-100%/0-50%:1.5x"), true)
+    set_section(N_("Rate Ramp"), NULL)
+    _add_integer_with_range(RAMP_DURATION_CFG, RAMP_DURATION_DEFAULT, 0, 2000,
+                            N_("Ramp duration (ms)"),
+                            N_("Time taken to move between the normal and the acceleration rate. "
+                               "0 switches the rate at once."), true)
+    _add_integer_with_range(RAMP_STEPS_CFG, RAMP_STEPS_DEFAULT, 1, 64,
+                            N_("Ramp steps"),
+                            N_("Number of rate changes a ramp is split into."), true)
+    _add_integer(RAMP_CURVE_CFG, RAMP_CURVE_DEFAULT,
+                 N_("Ramp curve"),
+                 N_("How the rate progresses during a ramp."), true)
+        change_integer_list(ramp_curve_values, ramp_curve_texts)
+    set_section(N_("Drag Speed"), NULL)
+    _add_bool(DRAG_SPEED_CFG, DRAG_SPEED_DEFAULT,
+              N_("Drag to change the speed"),
+              N_("Once the hold is active, dragging horizontally changes the rate like a jog wheel."), true)
+    _add_float(DRAG_MIN_RATE_CFG, DRAG_MIN_RATE_DEFAULT,
+              N_("Minimum drag rate"),
+              N_("Rate reached when dragging left by half the video width."), true)
+    _add_float(DRAG_MAX_RATE_CFG, DRAG_MAX_RATE_DEFAULT,
+              N_("Maximum drag rate"),
+              N_("Rate reached when dragging right by half the video width."), true)
+    _add_float(DRAG_STEP_CFG, DRAG_STEP_DEFAULT,
+              N_("Drag rate step"),
+              N_("Dragged rates are rounded to multiples of this value."), true)
+    set_section(N_("Auto Speed"), NULL)
+    _add_bool(AUTO_SPEED_CFG, AUTO_SPEED_DEFAULT,
+              N_("Accelerate through still scenes"),
+              N_("Compare consecutive pictures and play at the auto speed rate while "
+                 "the picture barely changes, going back to the normal rate on motion."), true)
+    _add_float(AUTO_SPEED_RATE_CFG, AUTO_SPEED_RATE_DEFAULT,
+              N_("Auto speed rate"),
+              N_("Playback rate for still scenes."), true)
+    _add_float(AUTO_SPEED_THRESHOLD_CFG, AUTO_SPEED_THRESHOLD_DEFAULT,
+              N_("Motion threshold"),
+              N_("Mean brightness difference between two compared pictures, out of 255, "
+                 "from which a scene counts as moving."), true)
+    _add_integer_with_range(AUTO_SPEED_INTERVAL_CFG, AUTO_SPEED_INTERVAL_DEFAULT, 1, 60,
+                            N_("Compared pictures interval"),
+                            N_("Only one picture out of this many is compared with the previous one."), true)
+    set_section(N_("Silence Skipping"), NULL)
+    _add_float(SILENCE_RATE_CFG, SILENCE_RATE_DEFAULT,
+              N_("Silence rate"),
+              N_("Playback rate while the audio is silent. Requires \"Speed Hold\" to be "
+                 "ticked in Preferences -> All -> Audio -> Filters."), true)
+    _add_integer_with_range(SILENCE_LEVEL_CFG, SILENCE_LEVEL_DEFAULT, -90, 0,
+                            N_("Silence level (dBFS)"),
+                            N_("Audio quieter than this counts as silence."), true)
+    _add_integer_with_range(SILENCE_DURATION_CFG, SILENCE_DURATION_DEFAULT, 50, 10000,
+                            N_("Minimum silence (ms)"),
+                            N_("How long the audio has to stay silent before accelerating."), true)
+    set_section(N_("Debugging"), NULL)
+    _add_string(TRACE_FILE_CFG, TRACE_FILE_DEFAULT,
+                N_("Event trace file"),
+                N_("When set, the last few thousand press, release, rate and OSD events are "
+                   "written to this file whenever a video closes. Print it with the "
+                   "speed_hold_trace tool."), true)
+    _add_string(INPUT_RECORD_CFG, INPUT_RECORD_DEFAULT,
+                N_("Mouse recording file"),
+                N_("When set, the mouse events received by the video filter are written to "
+                   "this file when it closes."), true)
+    _add_string(INPUT_REPLAY_CFG, INPUT_REPLAY_DEFAULT,
+                N_("Mouse replay file"),
+                N_("When set, the mouse events of this recording are played back at their "
+                   "recorded times once a video opens, and the real ones are ignored until "
+                   "it ends. Use with the event trace file to compare runs."), true)
+    set_section(N_("Adaptive Rate"), NULL)
+    _add_bool(ADAPTIVE_RATE_CFG, ADAPTIVE_RATE_DEFAULT,
+              N_("Limit the rate to what the decoder sustains"),
+              N_("Lower the acceleration rate while pictures are dropped or displayed late, "
+                 "and start the next holds at the rate that could be sustained."), true)
+    _add_integer_with_range(MAX_DROP_CFG, MAX_DROP_DEFAULT, 1, 50,
+                            N_("Dropped pictures threshold (%)"),
+                            N_("Share of dropped or late pictures above which the rate is lowered."), true)
+    _add_bool(SPEED_CONTROL_CFG, SPEED_CONTROL_DEFAULT,
+              N_("Correct the rate to reach the requested speed"),
+              N_("Measure how fast the media time advances during a hold and adjust the rate "
+                 "until it matches the requested one. Not used while the rate is limited "
+                 "to what the decoder sustains."), true)
         add_submodule()
         set_capability("interface", 0)
 #if LIBVLC_VERSION_MAJOR <= 3
@@ -179,134 +426,386 @@ vlc_module_begin()
 #endif
         set_subcategory(SUBCAT_INTERFACE_CONTROL)
         set_callbacks(OpenInterface, CloseInterface)
+        add_submodule()
+        set_capability("audio filter", 0)
+#if LIBVLC_VERSION_MAJOR >= 4
+        set_callback(OpenAudioFilter)
+#else
+        set_category(CAT_AUDIO)
+        set_subcategory(SUBCAT_AUDIO_AFILTER)
+        set_callbacks(OpenAudioFilter, CloseAudioFilter)
+#endif
 vlc_module_end()
 
-static void pause_play(void)
+// Rebuilds the zone LUT when the options or the video size changed since it
+// was last built, so a press only costs a table lookup
+static void update_zones(filter_sys_t *p_sys, const speed_hold_settings_t *p_settings)
 {
-    if (!p_interface_thread) {
-        return;
-    }
+    unsigned width = p_sys->width;
+    unsigned height = p_sys->height;
 
-#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
-    playlist_t* p_playlist = pl_Get(p_interface_thread);
-    if (!p_playlist) {
-        return;
-    }
-    playlist_status_t status = playlist_Status(p_playlist);
-    playlist_Control(p_playlist, status == PLAYLIST_RUNNING ? PLAYLIST_PAUSE : PLAYLIST_PLAY , 0);
-#elif LIBVLC_VERSION_MAJOR >= 4
-    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_interface_thread));
-    if (!player) {
+    if (p_sys->zones_generation == p_settings->generation && p_sys->zones.width == width
+     && p_sys->zones.height == height)
         return;
+
+    zone_map_t edges;
+    const zone_map_t *p_map = &p_settings->zones;
+    if (p_map->count == 0) {
+        zone_map_edges(&edges, p_settings->edge_rate);
+        p_map = &edges;
     }
-    vlc_player_Lock(player);
-    int state = vlc_player_GetState(player);
-    state == VLC_PLAYER_STATE_PLAYING ? vlc_player_Pause(player) : vlc_player_Resume(player);
-    vlc_player_Unlock(player);
-#endif
+
+    if (zone_lut_build(&p_sys->zones, p_map, width, height) != VLC_SUCCESS)
+        msg_Warn(p_sys->p_obj, "[Speed Hold] Couldn't build the speed zones for %ux%u", width, height);
+    p_sys->zones_generation = p_settings->generation;
+}
+
+// Tells the worker what to remember of the current media, see
+// worker_push_memory()
+static void speed_memory_push(filter_sys_t *p_sys, speed_hold_queue_t *p_queue, float base_rate, float hold_rate)
+{
+    if (p_sys->media_key != 0)
+        worker_push_memory(p_queue, p_sys->media_key, base_rate, hold_rate);
 }
 
 static void timer_callback(void* data)
 {
-    if (!atomic_load(&timer_scheduled)) {
+    filter_sys_t *p_sys = data;
+
+    // hold_release() spins while the hold is being fired, possibly on a
+    // thread holding the player lock, so whatever takes a lock or logs is
+    // done outside of that window, which only pushes the commands
+    float rate = p_sys->rate_on_fire ? GetRate(p_sys->player.p_intf) : 0.f;
+    float rate_ceiling = worker_get_rate_ceiling(p_sys->player.p_worker);
+    _vlc_tick_t fired = _vlc_tick_now();
+
+    if (!hold_fire(&p_sys->hold)) {
+        if (hold_release(&p_sys->hold) == HOLD_RELEASE_RESTORE) {
+            // scheduled when parking a hold, no video came to take it over
+            msg_Dbg(p_sys->player.p_intf, "[Speed Hold] Carried hold expired, restoring original rate: %f",
+                    p_sys->original_rate);
+            worker_push_group(p_sys->player.p_timer_queue, GROUP_CMD_RELEASE, p_sys->original_rate, NULL);
+            worker_push_rate(p_sys->player.p_timer_queue, p_sys->original_rate);
+            worker_push_osd_text(p_sys->player.p_timer_queue, "");
+            worker_push_hold_end(p_sys->player.p_timer_queue);
+        }
         return;
     }
-    atomic_store(&timer_scheduled, false);
 
-    filter_t *p_filter = (filter_t *) data;
-    filter_sys_t *p_sys = p_filter->p_sys;
-    if (!p_sys) return;
+    // a parked state has no press left to fire, so the settings are valid
+    const speed_hold_settings_t *p_settings = settings_hold(&p_sys->settings);
+    if (p_sys->rate_on_fire)
+        p_sys->original_rate = rate;
 
-    msg_Dbg(p_filter, "[Speed Hold] Timer fired, starting acceleration");
-
-    if (!p_sys->rate_changed_by_mouse) {
-        p_sys->rate_changed_by_mouse = true;
-        
+    if (p_sys->hold_rewind) {
+        worker_push_group(p_sys->player.p_timer_queue, GROUP_CMD_SKIM, -p_settings->rewind_rate, NULL);
+        worker_push_skim(p_sys->player.p_timer_queue, -p_settings->rewind_rate);
+        if (p_settings->display_speed) {
+            char text[32] = "-";
+            format_speed_text(text + 1, sizeof(text) - 1, p_settings->rewind_rate);
+            worker_push_osd_text(p_sys->player.p_timer_queue, text);
+        }
+        if (p_settings->audio_bypass != AUDIO_BYPASS_NONE)
+            worker_push_audio_bypass(p_sys->player.p_timer_queue, p_settings->audio_bypass);
+        speed_memory_push(p_sys, p_sys->player.p_timer_queue, p_sys->original_rate, -1.f);
+        p_sys->hold_rate = p_settings->rewind_rate;
+        p_sys->hold_skimming = true;
+    } else {
         float new_rate;
-        bool regional_speed = var_InheritBool(p_filter, REGIONAL_SPEED_CFG);
-
-        if (regional_speed) {
-            int width = p_filter->fmt_in.video.i_width;
-            float percentage = (float)p_sys->mouse_x / width;
-            
-            if (percentage < 0.2f || percentage > 0.8f) {
-                new_rate = var_InheritFloat(p_filter, EDGE_ACCELERATION_RATE_CFG);
-            } else {
-                new_rate = var_InheritFloat(p_filter, ACCELERATION_RATE_CFG);
-            }
+        if (p_settings->regional_speed) {
+            // built on the press, rebuilding allocates
+            new_rate = zone_lut_rate(&p_sys->zones, p_sys->mouse_x, p_sys->mouse_y);
+            if (new_rate == 0.f)
+                new_rate = p_settings->rate;
         } else {
-            new_rate = var_InheritFloat(p_filter, ACCELERATION_RATE_CFG);
+            new_rate = p_sys->memory_rate > 0.f ? p_sys->memory_rate : p_settings->rate;
         }
+        // a regional rate belongs to the zone, not to the media
+        speed_memory_push(p_sys, p_sys->player.p_timer_queue, p_sys->original_rate,
+                          p_settings->regional_speed ? -1.f : new_rate);
 
-        msg_Dbg(p_filter, "[Speed Hold] Accelerating to rate: %f", new_rate);
-        SetRate(p_interface_thread, new_rate);
-
-        char text[32];
-        if (new_rate == (float)(int)new_rate) {
-            snprintf(text, sizeof(text), "%dx", (int)new_rate);
+        float shown_rate = new_rate;
+        p_sys->hold_skimming = p_settings->skim_rate > 0.f && new_rate >= p_settings->skim_rate;
+        if (p_sys->hold_skimming) {
+            worker_push_group(p_sys->player.p_timer_queue, GROUP_CMD_SKIM, new_rate, NULL);
+            worker_push_skim(p_sys->player.p_timer_queue, new_rate);
         } else {
-            snprintf(text, sizeof(text), "%.2fx", new_rate);
+            hold_params_t hold = {
+                .ramp = p_settings->ramp,
+                .max_drop_ratio = p_settings->adaptive_rate ? p_settings->max_drop / 100.f : 0.f,
+                .display_speed = p_settings->display_speed,
+                .fast_decoding = p_settings->fast_decoding_rate > 0.f && new_rate >= p_settings->fast_decoding_rate,
+                .speed_control = p_settings->speed_control,
+                .pressed = p_sys->pressed,
+            };
+
+            worker_push_group(p_sys->player.p_timer_queue, GROUP_CMD_HOLD, new_rate, &hold.ramp);
+            worker_push_hold(p_sys->player.p_timer_queue, new_rate, &hold);
+
+            // the worker starts from the rate the previous holds could sustain
+            if (p_settings->adaptive_rate && rate_ceiling > 0.f && rate_ceiling < new_rate)
+                shown_rate = rate_ceiling;
+        }
+
+        if (p_settings->audio_bypass != AUDIO_BYPASS_NONE)
+            worker_push_audio_bypass(p_sys->player.p_timer_queue, p_settings->audio_bypass);
+
+        if (p_settings->display_speed) {
+            char text[32];
+            format_speed_text(text, sizeof(text), shown_rate);
+            worker_push_osd_text(p_sys->player.p_timer_queue, text);
         }
-        display_speed_text(p_interface_thread, text);
+
+        p_sys->hold_rate = shown_rate;
+        p_sys->drag_step = p_settings->drag_step > 0.f ? lroundf(shown_rate / p_settings->drag_step) : 0;
     }
+
+    bool rewind = p_sys->hold_rewind;
+    bool skimming = p_sys->hold_skimming;
+    float hold_rate = p_sys->hold_rate;
+    settings_release(&p_sys->settings);
+    hold_fired(&p_sys->hold);
+
+    // The filter may close from now on, the interface is the object left
+    trace_record(TRACE_TIMER_FIRE, 0.f);
+    metrics_record(METRIC_TIMER_JITTER, fired - p_sys->hold_deadline);
+    msg_Dbg(p_sys->player.p_intf, "[Speed Hold] Timer fired, %s at rate: %f",
+            rewind ? "skimming backwards" : skimming ? "skimming" : "accelerating", hold_rate);
 }
 
-static int mouse(filter_t *p_filter, vlc_mouse_t *p_mouse_out, const vlc_mouse_t *p_mouse_old, const vlc_mouse_t *p_mouse_new)
+// Maps the horizontal distance from the press point onto the drag rate range:
+// half the video width to the right reaches the maximum rate, half of it to
+// the left the minimum one. Moves arrive at hundreds of Hz, so a rate is only
+// queued when it crosses a step boundary.
+static void drag(filter_sys_t *p_sys, const speed_hold_settings_t *p_settings, const vlc_mouse_t *p_mouse)
 {
-    *p_mouse_out = *p_mouse_new;
+    if (!p_settings->drag_speed || p_sys->hold_skimming || p_settings->drag_step <= 0.f
+     || p_sys->width == 0)
+        return;
 
-    // Ignore mouse move events that don't involve a button press/release
-    if (p_mouse_old->i_pressed == p_mouse_new->i_pressed)
-        return VLC_SUCCESS;
+    float distance = (p_mouse->i_x - p_sys->mouse_x) / (p_sys->width / 2.f);
+    if (distance > 1.f)
+        distance = 1.f;
+    else if (distance < -1.f)
+        distance = -1.f;
 
-    filter_sys_t *p_sys = p_filter->p_sys;
-    if (!p_sys) return VLC_SUCCESS;
+    float rate = p_sys->hold_rate;
+    if (distance > 0.f)
+        rate += distance * (p_settings->drag_max_rate - p_sys->hold_rate);
+    else
+        rate += distance * (p_sys->hold_rate - p_settings->drag_min_rate);
 
-    msg_Dbg(p_filter, "[Speed Hold] mouse event: old_pressed=%d, new_pressed=%d", p_mouse_old->i_pressed, p_mouse_new->i_pressed);
+    long step = lroundf(rate / p_settings->drag_step);
+    if (step < 1)
+        step = 1;
+    if (step == p_sys->drag_step)
+        return;
 
-    const int mouse_button = 1; // MOUSE_BUTTON_LEFT
-    msg_Dbg(p_filter, "[Speed Hold] hardcoded mouse button: %d", mouse_button);
+    p_sys->drag_step = step;
+    speed_memory_push(p_sys, p_sys->player.p_mouse_queue, -1.f, step * p_settings->drag_step);
+    worker_push_drag(p_sys->player.p_mouse_queue, step * p_settings->drag_step, p_settings->display_speed);
+}
+
+static void mouse_handle(filter_sys_t *p_sys, const speed_hold_settings_t *p_settings,
+                         const vlc_mouse_t *p_mouse_old, const vlc_mouse_t *p_mouse_new)
+{
+    // This video output never saw the press of a carried hold, the first
+    // event tells whether the button is still down
+    vlc_mouse_t carried_old;
+    if (p_sys->hold_carried) {
+        p_sys->hold_carried = false;
+        carried_old = *p_mouse_old;
+        carried_old.i_pressed |= p_sys->hold_button;
+        p_mouse_old = &carried_old;
+    }
+
+    // Mouse move events that don't involve a button press/release only
+    // matter while dragging the rate of a hold
+    if (p_mouse_old->i_pressed == p_mouse_new->i_pressed) {
+        if (hold_is_active(&p_sys->hold))
+            drag(p_sys, p_settings, p_mouse_new);
+        return;
+    }
+
+    // Until it's released, the button of the press in progress is the only
+    // one followed
+    int mouse_button = p_sys->hold_button;
+    if (!mouse_button) {
+        int pressed = p_mouse_new->i_pressed & ~p_mouse_old->i_pressed;
+        if (pressed & p_settings->mouse_button)
+            mouse_button = p_settings->mouse_button;
+        else if (pressed & p_settings->rewind_button)
+            mouse_button = p_settings->rewind_button;
+        else
+            return;
+    }
 
     bool is_pressed = p_mouse_new->i_pressed & mouse_button;
     bool was_pressed = p_mouse_old->i_pressed & mouse_button;
 
     if (is_pressed && !was_pressed) {
-        msg_Dbg(p_filter, "[Speed Hold] Mouse button pressed, scheduling timer");
+        trace_record(TRACE_PRESS, 0.f);
+        msg_Dbg(p_sys->p_obj, "[Speed Hold] Mouse button pressed, scheduling timer");
         p_sys->mouse_x = p_mouse_new->i_x;
         p_sys->mouse_y = p_mouse_new->i_y;
-        atomic_store(&timer_scheduled, true);
-        int64_t delay = var_InheritInteger(p_filter, HOLD_DELAY_CFG);
-        vlc_timer_schedule(timer, false, delay * 1000, 0);
+        // before hold_press(), no timer can claim a hold and read the LUT meanwhile
+        if (p_settings->regional_speed)
+            update_zones(p_sys, p_settings);
+        p_sys->hold_button = mouse_button;
+        p_sys->hold_rewind = mouse_button != p_settings->mouse_button;
+        hold_press(&p_sys->hold);
+        int64_t delay = p_settings->hold_delay;
+        p_sys->pressed = _vlc_tick_now();
+        p_sys->hold_deadline = p_sys->pressed + delay * 1000;
+        vlc_timer_schedule(p_sys->timer, false, delay * 1000, 0);
 
     } else if (!is_pressed && was_pressed) {
-        msg_Dbg(p_filter, "[Speed Hold] Mouse button released");
+        trace_record(TRACE_RELEASE, 0.f);
+        msg_Dbg(p_sys->p_obj, "[Speed Hold] Mouse button released");
         // Always unschedule the timer on release
-        vlc_timer_schedule(timer, false, 0, 0);
+        vlc_timer_schedule(p_sys->timer, false, 0, 0);
+        p_sys->hold_button = 0;
 
-        // Reset timer_scheduled flag immediately. The logic for click/hold
-        // relies on `p_sys->rate_changed_by_mouse` being set by the timer_callback
-        // if it was a hold.
-        atomic_store(&timer_scheduled, false);
+        hold_release_t release = hold_release(&p_sys->hold);
 
-        if (p_sys->rate_changed_by_mouse) {
+        if (release == HOLD_RELEASE_RESTORE) {
             // Timer already fired and changed rate, so it was a hold
-            msg_Dbg(p_filter, "[Speed Hold] Hold detected, restoring original rate: %f", p_sys->original_rate);
-            p_sys->rate_changed_by_mouse = false;
-            SetRate(p_interface_thread, p_sys->original_rate);
-            display_speed_text(p_interface_thread, "");
-        } else {
+            msg_Dbg(p_sys->p_obj, "[Speed Hold] Hold detected, restoring original rate: %f", p_sys->original_rate);
+            worker_push_group(p_sys->player.p_mouse_queue, GROUP_CMD_RELEASE, p_sys->original_rate,
+                              &p_settings->ramp);
+            worker_push_ramp(p_sys->player.p_mouse_queue, p_sys->original_rate, &p_settings->ramp);
+            worker_push_osd_text(p_sys->player.p_mouse_queue, "");
+            worker_push_hold_end(p_sys->player.p_mouse_queue);
+            speed_memory_push(p_sys, p_sys->player.p_mouse_queue, 0.f, -1.f);
+        } else if (release == HOLD_RELEASE_CLICK && p_sys->hold_rewind) {
+            msg_Dbg(p_sys->p_obj, "[Speed Hold] Click on the rewind button, ignoring it");
+        } else if (release == HOLD_RELEASE_CLICK) {
             // Timer was still scheduled and didn't fire, so it's a click
-            msg_Dbg(p_filter, "[Speed Hold] Click detected, pausing/playing");
-            pause_play();
+            trace_record(TRACE_CLICK, 0.f);
+            msg_Dbg(p_sys->p_obj, "[Speed Hold] Click detected, pausing/playing");
+            worker_push_pause_play(p_sys->player.p_mouse_queue);
         }
     }
+}
+
+static void mouse_event(filter_sys_t *p_sys, const vlc_mouse_t *p_mouse_old, const vlc_mouse_t *p_mouse_new)
+{
+    mouse_handle(p_sys, settings_hold(&p_sys->settings), p_mouse_old, p_mouse_new);
+    settings_release(&p_sys->settings);
+}
+
+static void replay_callback(void *opaque, const vlc_mouse_t *p_old, const vlc_mouse_t *p_new)
+{
+    mouse_event(opaque, p_old, p_new);
+}
+
+static int mouse(filter_t *p_filter, vlc_mouse_t *p_mouse_out, const vlc_mouse_t *p_mouse_old, const vlc_mouse_t *p_mouse_new)
+{
+    *p_mouse_out = *p_mouse_new;
+
+    filter_sys_t *p_sys = p_filter->p_sys;
+    if (!p_sys) return VLC_SUCCESS;
+
+    // the replay thread is the only one handling the events until it's done
+    if (p_sys->p_replay && replay_is_running(p_sys->p_replay))
+        return VLC_SUCCESS;
+
+    replay_record(&p_sys->recorder, p_mouse_new);
+    mouse_event(p_sys, p_mouse_old, p_mouse_new);
 
     return VLC_SUCCESS;
 }
 
+static void auto_speed_stop(filter_t *p_filter, bool display_speed)
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    p_sys->auto_still = 0;
+    if (!p_sys->auto_active)
+        return;
+
+    msg_Dbg(p_filter, "[Speed Hold] Motion detected, accelerating no more");
+    p_sys->auto_active = false;
+    worker_push_auto_rate(p_sys->player.p_filter_queue, WORKER_AUTO_MOTION, 0.f, &(ramp_params_t) { 0 },
+                          display_speed ? "" : NULL);
+    speed_memory_push(p_sys, p_sys->player.p_filter_queue, 0.f, -1.f);
+}
+
+// Compares the luma of every auto_speed_interval-th picture with the previous
+// one and accelerates while the scene stays still
+static void auto_speed(filter_t *p_filter, const speed_hold_settings_t *p_settings, const picture_t *p_pic)
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    // the hold owns the rate until its release restores the original one
+    if (!hold_is_idle(&p_sys->hold)) {
+        p_sys->auto_active = false;
+        p_sys->auto_still = 0;
+        return;
+    }
+
+    // a hold, e.g. from the sync group, cancelled it and restored the rate
+    if (p_sys->auto_active && worker_get_auto_cancels(p_sys->player.p_worker) != p_sys->auto_cancels) {
+        p_sys->auto_active = false;
+        p_sys->auto_still = 0;
+        speed_memory_push(p_sys, p_sys->player.p_filter_queue, 0.f, -1.f);
+    }
+
+    if (++p_sys->auto_pictures < p_settings->auto_speed_interval)
+        return;
+    p_sys->auto_pictures = 0;
+
+    const plane_t *p_luma = &p_pic->p[0];
+    if (!vlc_fourcc_IsYUV(p_filter->fmt_in.video.i_chroma) || p_luma->i_pixel_pitch != 1)
+        return;
+
+    _vlc_tick_t start = _vlc_tick_now();
+    float difference = motion_compare(&p_sys->motion, p_luma->p_pixels, p_luma->i_pitch,
+                                      p_luma->i_visible_pitch, p_luma->i_visible_lines);
+    _vlc_tick_t elapsed = _vlc_tick_now() - start;
+
+    p_sys->auto_samples++;
+    p_sys->auto_total_time += elapsed;
+    if (elapsed > p_sys->auto_max_time)
+        p_sys->auto_max_time = elapsed;
+
+    if (difference < 0.f)
+        return;
+
+    // More media time passes between two pictures at a higher rate, which
+    // makes them differ more for the same motion
+    float rate = p_sys->auto_active ? p_settings->auto_speed_rate : p_sys->original_rate;
+    if (difference / rate >= p_settings->auto_speed_threshold) {
+        auto_speed_stop(p_filter, p_settings->display_speed);
+        return;
+    }
+
+    if (p_sys->auto_active || ++p_sys->auto_still < AUTO_SPEED_STILL_SAMPLES)
+        return;
+
+    msg_Dbg(p_filter, "[Speed Hold] Still scene, accelerating to rate: %f", p_settings->auto_speed_rate);
+    p_sys->auto_active = true;
+    p_sys->auto_cancels = worker_get_auto_cancels(p_sys->player.p_worker);
+    char text[32];
+    format_speed_text(text, sizeof(text), p_settings->auto_speed_rate);
+    worker_push_auto_rate(p_sys->player.p_filter_queue, WORKER_AUTO_MOTION, p_settings->auto_speed_rate,
+                          &p_settings->ramp, p_settings->display_speed ? text : NULL);
+    // the rate auto speed picked isn't the one the media plays at
+    speed_memory_push(p_sys, p_sys->player.p_filter_queue, p_sys->original_rate, -1.f);
+}
+
 static picture_t *filter(filter_t *p_filter, picture_t *p_pic_in)
 {
-    UNUSED(p_filter);
+    filter_sys_t *p_sys = p_filter->p_sys;
+    if (!p_sys || !p_pic_in) return p_pic_in;
+
+    const speed_hold_settings_t *p_settings = settings_hold(&p_sys->settings);
+    if (p_settings->auto_speed)
+        auto_speed(p_filter, p_settings, p_pic_in);
+    else
+        auto_speed_stop(p_filter, p_settings->display_speed);
+    settings_release(&p_sys->settings);
+
     return p_pic_in;
 }
 
@@ -331,56 +830,167 @@ static void print_version(vlc_object_t *p_obj)
     msg_Dbg(p_obj, VERSION_HOMEPAGE);
 }
 
-static int OpenFilter(vlc_object_t *p_this)
+// Picks up the rates the current media was last played with. The base rate
+// becomes the one to restore, and is applied unless a hold carries over.
+static void speed_memory_load(filter_sys_t *p_sys)
 {
-    filter_t *p_filter = (filter_t *) p_this;
+    char *psz_uri = GetMediaURI(p_sys->player.p_intf);
+    if (!psz_uri)
+        return;
+    p_sys->media_key = history_key(psz_uri);
+    free(psz_uri);
 
-    print_version(p_this);
-    msg_Dbg(p_filter, "[Speed Hold] filter sub-plugin opened");
+    // filter() doesn't run yet, this thread can push on its queue
+    history_entry_t entry;
+    if (history_lookup(p_sys->media_key, &entry)) {
+        p_sys->memory_rate = entry.hold_rate;
+        if (entry.base_rate > 0.f && entry.base_rate != p_sys->original_rate) {
+            msg_Dbg(p_sys->p_obj, "[Speed Hold] Remembered rate: %f, hold rate: %f",
+                    entry.base_rate, entry.hold_rate);
+            p_sys->original_rate = entry.base_rate;
+            if (!hold_is_active(&p_sys->hold))
+                worker_push_rate(p_sys->player.p_filter_queue, entry.base_rate);
+        }
+    }
 
-    if (!p_interface_thread) {
-        msg_Err(p_filter, "[Speed Hold] interface sub-plugin is not initialized. "
-                "Did you tick \"Speed Hold\" checkbox in "
-                "Preferences -> All -> Interface -> Control interfaces? "
-                "Don't forget to restart VLC afterwards");
-        return VLC_EGENERIC;
+    // the rate of a carried hold isn't the one the media plays at
+    speed_memory_push(p_sys, p_sys->player.p_filter_queue,
+                      hold_is_active(&p_sys->hold) ? p_sys->original_rate : 0.f, p_sys->memory_rate);
+}
+
+// Called when the state can't be parked, or by the registry for the parked
+// ones once the interface closes
+static void filter_state_release(player_binding_t *p_binding)
+{
+    filter_sys_t *p_sys = container_of(p_binding, filter_sys_t, player);
+
+    vlc_timer_destroy(p_sys->timer);
+
+    // The timer is gone, so this thread is now the only producer of the
+    // timer queue
+    if (hold_release(&p_sys->hold) == HOLD_RELEASE_RESTORE) {
+        worker_push_group(p_sys->player.p_timer_queue, GROUP_CMD_RELEASE, p_sys->original_rate, NULL);
+        worker_push_rate(p_sys->player.p_timer_queue, p_sys->original_rate);
+        worker_push_osd_text(p_sys->player.p_timer_queue, "");
+        worker_push_hold_end(p_sys->player.p_timer_queue);
     }
 
+    registry_remove_filter(&p_sys->player);
+    zone_lut_clean(&p_sys->zones);
+    motion_clean(&p_sys->motion);
+    free(p_sys);
+}
+
+// Allocates the part of the filter state that outlives a filter: the player
+// binding, the hold timer and the hold itself
+static int filter_state_create(vlc_object_t *p_obj, filter_t *p_filter, filter_sys_t **pp_sys)
+{
     filter_sys_t *p_sys = calloc(1, sizeof(filter_sys_t));
     if (!p_sys)
         return VLC_ENOMEM;
 
-    p_filter->p_sys = p_sys;
-    p_sys->rate_changed_by_mouse = false;
+    int ret = registry_add_filter(p_filter, &p_sys->player);
+    if (ret != VLC_SUCCESS) {
+        if (ret == VLC_EGENERIC)
+            msg_Err(p_obj, "[Speed Hold] interface sub-plugin is not initialized. "
+                    "Did you tick \"Speed Hold\" checkbox in "
+                    "Preferences -> All -> Interface -> Control interfaces? "
+                    "Don't forget to restart VLC afterwards");
+        free(p_sys);
+        return ret;
+    }
 
-#if LIBVLC_VERSION_MAJOR >= 4
-    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_interface_thread));
-    vlc_player_Lock(player);
-    p_sys->original_rate = vlc_player_GetRate(player);
-    vlc_player_Unlock(player);
-#else
-    playlist_t* p_playlist = pl_Get(p_interface_thread);
-    input_thread_t *p_input = playlist_CurrentInput(p_playlist);
-    if(p_input)
+    if (vlc_timer_create(&p_sys->timer, timer_callback, p_sys) != VLC_SUCCESS)
     {
-        p_sys->original_rate = var_GetFloat(p_input, "rate");
-        vlc_object_release(p_input);
-    } else {
-        p_sys->original_rate = 1.0f;
-        msg_Warn(p_filter, "[Speed Hold] Could not get current input, original_rate set to 1.0");
+        msg_Err(p_obj, "Couldn't create a timer");
+        registry_remove_filter(&p_sys->player);
+        free(p_sys);
+        return VLC_EGENERIC;
     }
-#endif
 
-    msg_Dbg(p_filter, "[Speed Hold] Original rate stored: %f", p_sys->original_rate);
+    p_sys->player.pf_release = filter_state_release;
+    hold_init(&p_sys->hold);
+    motion_init(&p_sys->motion);
 
-    if (vlc_timer_create(&timer, timer_callback, p_filter) != VLC_SUCCESS)
-    {
-        msg_Err(p_filter, "Couldn't create a timer");
-        free(p_sys);
+    *pp_sys = p_sys;
+    return VLC_SUCCESS;
+}
+
+// Hands the state over to the next filter to open
+static void filter_state_park(filter_sys_t *p_sys)
+{
+    if (!registry_park_filter(&p_sys->player))
+        filter_state_release(&p_sys->player);
+}
+
+static int OpenFilter(vlc_object_t *p_this)
+{
+    filter_t *p_filter = (filter_t *) p_this;
+    filter_sys_t *p_sys;
+
+    if (var_InheritBool(p_filter, MOUSE_CAPTURE_CFG)) {
+        msg_Dbg(p_filter, "[Speed Hold] the interface captures the mouse, not inserting the filter");
         return VLC_EGENERIC;
     }
-    timer_initialized = true;
-    atomic_store(&timer_scheduled, false);
+
+    // The state of the previous item is reused, an item change then costs no
+    // allocation, timer creation or logging beyond this
+    player_binding_t *p_binding = registry_unpark_filter(p_filter);
+    if (p_binding) {
+        p_sys = container_of(p_binding, filter_sys_t, player);
+        vlc_timer_schedule(p_sys->timer, false, 0, 0);
+        msg_Dbg(p_filter, "[Speed Hold] filter sub-plugin opened, reusing the previous state");
+    } else {
+        print_version(p_this);
+        msg_Dbg(p_filter, "[Speed Hold] filter sub-plugin opened");
+
+        int ret = filter_state_create(p_this, p_filter, &p_sys);
+        if (ret != VLC_SUCCESS)
+            return ret;
+    }
+
+    if (settings_init(&p_sys->settings, p_this) != VLC_SUCCESS) {
+        filter_state_park(p_sys);
+        return VLC_ENOMEM;
+    }
+
+    p_filter->p_sys = p_sys;
+    p_sys->p_obj = p_this;
+    p_sys->width = p_filter->fmt_in.video.i_width;
+    p_sys->height = p_filter->fmt_in.video.i_height;
+    const speed_hold_settings_t *p_settings = settings_hold(&p_sys->settings);
+    if (p_settings->regional_speed)
+        update_zones(p_sys, p_settings);
+    settings_release(&p_sys->settings);
+
+    // A hold still running keeps the rate to restore from before it
+    if (hold_is_active(&p_sys->hold)) {
+        p_sys->hold_carried = true;
+        msg_Dbg(p_filter, "[Speed Hold] Carrying the hold over, original rate: %f", p_sys->original_rate);
+    } else {
+        p_sys->original_rate = GetRate(p_sys->player.p_intf);
+        p_sys->hold_button = 0;
+        msg_Dbg(p_filter, "[Speed Hold] Original rate stored: %f", p_sys->original_rate);
+    }
+
+    p_sys->memory_rate = 0.f;
+    if (var_InheritBool(p_filter, SPEED_MEMORY_CFG))
+        speed_memory_load(p_sys);
+
+    // what the previous media could sustain says nothing about this one
+    worker_reset_rate_ceiling(p_sys->player.p_worker);
+    worker_attach_osd(p_sys->player.p_worker, p_this);
+
+    _vlc_tick_t opened = _vlc_tick_now();
+    char *psz_record = var_InheritString(p_filter, INPUT_RECORD_CFG);
+    if (psz_record && *psz_record && replay_recorder_init(&p_sys->recorder, opened) != VLC_SUCCESS)
+        msg_Warn(p_filter, "[Speed Hold] Couldn't start recording the mouse events");
+    free(psz_record);
+
+    char *psz_replay = var_InheritString(p_filter, INPUT_REPLAY_CFG);
+    if (psz_replay && *psz_replay)
+        p_sys->p_replay = replay_start(p_this, psz_replay, opened, replay_callback, p_sys);
+    free(psz_replay);
 
 #if LIBVLC_VERSION_MAJOR >= 4
     p_filter->ops = &filter_ops;
@@ -399,37 +1009,432 @@ static void CloseFilter(vlc_object_t *p_this)
 
     msg_Dbg(p_this, "[Speed Hold] filter sub-plugin closed");
 
-    if (timer_initialized) {
-        vlc_timer_destroy(timer);
-        timer_initialized = false;
-    }
-
     if(p_sys)
     {
-        if (p_sys->rate_changed_by_mouse) {
+        // before the hold, which the replayed presses drive
+        if (p_sys->p_replay) {
+            replay_stop(p_sys->p_replay);
+            p_sys->p_replay = NULL;
+        }
+
+        // A running hold carries over to the next filter. A pending press is
+        // cancelled, after which the timer won't push anything, so this
+        // thread can push on its queue.
+        if (!hold_is_active(&p_sys->hold) && hold_release(&p_sys->hold) == HOLD_RELEASE_RESTORE) {
             msg_Dbg(p_this, "[Speed Hold] Restoring original rate on close: %f", p_sys->original_rate);
-            SetRate(p_interface_thread, p_sys->original_rate);
-            display_speed_text(p_interface_thread, "");
+            worker_push_group(p_sys->player.p_timer_queue, GROUP_CMD_RELEASE, p_sys->original_rate, NULL);
+            worker_push_rate(p_sys->player.p_timer_queue, p_sys->original_rate);
+            worker_push_osd_text(p_sys->player.p_timer_queue, "");
+            worker_push_hold_end(p_sys->player.p_timer_queue);
+        }
+
+        // Written by the worker, once the timer can't fire a press reading the
+        // media key anymore. filter() is done, this thread can push on its
+        // queue. A carried hold keeps its original rate.
+        if (p_sys->media_key != 0) {
+            worker_push_memory_save(p_sys->player.p_filter_queue, p_sys->media_key);
+            p_sys->media_key = 0;
+        }
+
+        // the timer ends a carried hold if no filter takes it over in time
+        vlc_timer_schedule(p_sys->timer, false, hold_is_active(&p_sys->hold) ? FILTER_CARRY_TIME : 0, 0);
+        p_sys->hold_carried = false;
+
+        // filter() won't run anymore, this thread can push on its queue
+        auto_speed_stop(p_filter, settings_hold(&p_sys->settings)->display_speed);
+        settings_release(&p_sys->settings);
+        if (p_sys->auto_samples > 0)
+            msg_Dbg(p_this, "[Speed Hold] auto speed: %" PRIu64 " pictures compared, "
+                    "avg %" PRId64 " us, max %" PRId64 " us", p_sys->auto_samples,
+                    (int64_t)(p_sys->auto_total_time / p_sys->auto_samples),
+                    (int64_t)p_sys->auto_max_time);
+        p_sys->auto_pictures = 0;
+        p_sys->auto_samples = 0;
+        p_sys->auto_total_time = 0;
+        p_sys->auto_max_time = 0;
+
+        char *psz_trace = var_InheritString(p_filter, TRACE_FILE_CFG);
+        if (psz_trace && *psz_trace && !trace_dump(psz_trace))
+            msg_Warn(p_this, "[Speed Hold] Couldn't write the event trace to %s", psz_trace);
+        free(psz_trace);
+
+        if (p_sys->recorder.p_events) {
+            char *psz_record = var_InheritString(p_filter, INPUT_RECORD_CFG);
+            if (psz_record && !replay_write(&p_sys->recorder, psz_record))
+                msg_Warn(p_this, "[Speed Hold] Couldn't write the mouse recording to %s", psz_record);
+            else
+                msg_Dbg(p_this, "[Speed Hold] %zu mouse events recorded", p_sys->recorder.count);
+            free(psz_record);
+            replay_recorder_clean(&p_sys->recorder);
         }
+
+        worker_detach_osd(p_sys->player.p_worker, p_this);
+        settings_clean(&p_sys->settings);
+        // the next filter starts over from the first generation
+        p_sys->zones_generation = 0;
+        filter_state_park(p_sys);
+    }
+}
+
+// Accelerates once the audio stayed below the silence level for long enough,
+// goes back to the rate from before on the first window that isn't silent.
+// The worker arbitrates with auto speed, which may keep the rate up.
+static void silence_window(filter_t *p_filter, const speed_hold_settings_t *p_settings)
+{
+    audio_filter_sys_t *p_sys = (void *) p_filter->p_sys;
+    unsigned rate = p_filter->fmt_in.audio.i_rate;
+
+    // a hold cancelled it, and its release restored the rate
+    if (p_sys->silence_active && worker_get_auto_cancels(p_sys->player.p_worker) != p_sys->auto_cancels) {
+        p_sys->silence_active = false;
+        p_sys->silent_frames = 0;
+    }
+
+    bool silent = level_rms_db(&p_sys->level) < p_settings->silence_level
+               && level_peak_db(&p_sys->level) < p_settings->silence_level + SILENCE_PEAK_MARGIN;
+
+    if (!silent) {
+        p_sys->silent_frames = 0;
+        if (p_sys->silence_active) {
+            msg_Dbg(p_filter, "[Speed Hold] Sound, skipping silences no more");
+            p_sys->silence_active = false;
+            worker_push_auto_rate(p_sys->player.p_filter_queue, WORKER_AUTO_SILENCE, 0.f,
+                                  &(ramp_params_t) { 0 }, p_settings->display_speed ? "" : NULL);
+        }
+        return;
+    }
+
+    p_sys->silent_frames += p_sys->window_frames;
+    if (p_sys->silence_active || p_sys->silent_frames < (uint64_t)rate * p_settings->silence_duration / 1000)
+        return;
+
+    msg_Dbg(p_filter, "[Speed Hold] Silence, accelerating to rate: %f", p_settings->silence_rate);
+    p_sys->silence_active = true;
+    p_sys->auto_cancels = worker_get_auto_cancels(p_sys->player.p_worker);
+    char text[32];
+    format_speed_text(text, sizeof(text), p_settings->silence_rate);
+    worker_push_auto_rate(p_sys->player.p_filter_queue, WORKER_AUTO_SILENCE, p_settings->silence_rate,
+                          &p_settings->ramp, p_settings->display_speed ? text : NULL);
+}
+
+static block_t *audio_filter(filter_t *p_filter, block_t *p_block)
+{
+    audio_filter_sys_t *p_sys = (void *) p_filter->p_sys;
+    const audio_format_t *p_fmt = &p_filter->fmt_in.audio;
+    _vlc_tick_t start = _vlc_tick_now();
+
+    level_add(&p_sys->level, (const float *) p_block->p_buffer, p_block->i_nb_samples * p_fmt->i_channels);
+    p_sys->window_frames += p_block->i_nb_samples;
+    if (p_sys->window_frames >= p_fmt->i_rate * SILENCE_WINDOW / CLOCK_FREQ) {
+        silence_window(p_filter, settings_hold(&p_sys->settings));
+        settings_release(&p_sys->settings);
+        level_reset(&p_sys->level);
+        p_sys->window_frames = 0;
+    }
+
+    _vlc_tick_t elapsed = _vlc_tick_now() - start;
+    p_sys->blocks++;
+    p_sys->total_time += elapsed;
+    if (elapsed > p_sys->max_time)
+        p_sys->max_time = elapsed;
+
+    return p_block;
+}
+
+#if LIBVLC_VERSION_MAJOR >= 4
+static const struct vlc_filter_operations audio_filter_ops =
+{
+    .filter_audio = audio_filter,
+    .close = (void (*)(filter_t *)) CloseAudioFilter,
+};
+#endif
+
+static int OpenAudioFilter(vlc_object_t *p_this)
+{
+    filter_t *p_filter = (filter_t *) p_this;
+
+    msg_Dbg(p_filter, "[Speed Hold] audio filter sub-plugin opened");
+
+    audio_filter_sys_t *p_sys = calloc(1, sizeof(audio_filter_sys_t));
+    if (!p_sys)
+        return VLC_ENOMEM;
+
+    int ret = registry_add_filter(p_filter, &p_sys->player);
+    if (ret != VLC_SUCCESS) {
+        if (ret == VLC_EGENERIC)
+            msg_Err(p_filter, "[Speed Hold] interface sub-plugin is not initialized");
+        free(p_sys);
+        return ret;
+    }
+
+    if (settings_init(&p_sys->settings, p_this) != VLC_SUCCESS) {
+        registry_remove_filter(&p_sys->player);
         free(p_sys);
+        return VLC_ENOMEM;
     }
+
+    level_init(&p_sys->level);
+
+    // the audio output converts to and from float around the filter
+    p_filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    aout_FormatPrepare(&p_filter->fmt_in.audio);
+    p_filter->fmt_out.audio = p_filter->fmt_in.audio;
+
+    p_filter->p_sys = (void *) p_sys;
+#if LIBVLC_VERSION_MAJOR >= 4
+    p_filter->ops = &audio_filter_ops;
+#else
+    p_filter->pf_audio_filter = audio_filter;
+#endif
+
+    return VLC_SUCCESS;
+}
+
+static void CloseAudioFilter(vlc_object_t *p_this)
+{
+    filter_t *p_filter = (filter_t *) p_this;
+    audio_filter_sys_t *p_sys = (void *) p_filter->p_sys;
+
+    msg_Dbg(p_this, "[Speed Hold] audio filter sub-plugin closed");
+
+    if (p_sys->silence_active) {
+        worker_push_auto_rate(p_sys->player.p_filter_queue, WORKER_AUTO_SILENCE, 0.f, &(ramp_params_t) { 0 },
+                              settings_hold(&p_sys->settings)->display_speed ? "" : NULL);
+        settings_release(&p_sys->settings);
+    }
+    if (p_sys->blocks > 0)
+        msg_Dbg(p_this, "[Speed Hold] silence detection: %" PRIu64 " audio blocks, "
+                "avg %" PRId64 " us, max %" PRId64 " us", p_sys->blocks,
+                (int64_t)(p_sys->total_time / p_sys->blocks), (int64_t)p_sys->max_time);
+
+    registry_remove_filter(&p_sys->player);
+    settings_clean(&p_sys->settings);
+    free(p_sys);
+}
+
+static int trace_dump_callback(vlc_object_t *p_this, const char *name,
+                               vlc_value_t oldval, vlc_value_t newval, void *data)
+{
+    VLC_UNUSED(name); VLC_UNUSED(oldval); VLC_UNUSED(data);
+
+    if (!newval.psz_string || !*newval.psz_string)
+        return VLC_SUCCESS;
+
+    if (!trace_dump(newval.psz_string)) {
+        msg_Warn(p_this, "[Speed Hold] Couldn't write the event trace to %s", newval.psz_string);
+        return VLC_EGENERIC;
+    }
+    msg_Dbg(p_this, "[Speed Hold] Event trace written to %s", newval.psz_string);
+
+    return VLC_SUCCESS;
+}
+
+static void capture_callback(void *opaque, const vlc_mouse_t *p_old, const vlc_mouse_t *p_new,
+                             unsigned width, unsigned height)
+{
+    filter_sys_t *p_state = opaque;
+    p_state->width = width;
+    p_state->height = height;
+    mouse_event(p_state, p_old, p_new);
+}
+
+static void capture_vouts_callback(void *opaque)
+{
+    filter_sys_t *p_state = opaque;
+    worker_osd_vouts_changed(p_state->player.p_worker);
+}
+
+// Drives the state a video filter would own from the mouse events of the
+// video outputs
+static int start_capture(intf_thread_t *p_intf, intf_sys_t *p_sys)
+{
+    filter_sys_t *p_state;
+    int ret = filter_state_create(VLC_OBJECT(p_intf), NULL, &p_state);
+    if (ret != VLC_SUCCESS)
+        return ret;
+
+    if (settings_init(&p_state->settings, VLC_OBJECT(p_intf)) != VLC_SUCCESS) {
+        filter_state_release(&p_state->player);
+        return VLC_ENOMEM;
+    }
+
+    p_state->p_obj = VLC_OBJECT(p_intf);
+    p_state->rate_on_fire = true;
+    p_state->original_rate = 1.f;
+
+    p_sys->p_capture = capture_start(p_intf, capture_callback, capture_vouts_callback, p_state);
+    if (!p_sys->p_capture) {
+        settings_clean(&p_state->settings);
+        filter_state_release(&p_state->player);
+        return VLC_ENOMEM;
+    }
+
+    p_sys->p_capture_sys = p_state;
+    return VLC_SUCCESS;
+}
+
+// Applies what another member of the sync group published, from the group
+// thread, which is the only one pushing on the group queue
+static void group_callback(void *opaque, const group_cmd_t *p_cmd)
+{
+    intf_sys_t *p_sys = opaque;
+
+    // The members may play at different rates, each one goes back to its own
+    if (p_cmd->type != GROUP_CMD_RELEASE && !p_sys->group_held) {
+        p_sys->group_held = true;
+        p_sys->group_rate = GetRate(p_sys->p_intf);
+    }
+
+    switch (p_cmd->type) {
+        case GROUP_CMD_HOLD:
+            worker_push_ramp(p_sys->p_group_queue, p_cmd->rate, &p_cmd->ramp);
+            break;
+        case GROUP_CMD_SKIM:
+            worker_push_skim(p_sys->p_group_queue, p_cmd->rate);
+            break;
+        case GROUP_CMD_RELEASE:
+            if (!p_sys->group_held)
+                break;
+            p_sys->group_held = false;
+            worker_push_ramp(p_sys->p_group_queue, p_sys->group_rate, &p_cmd->ramp);
+            worker_push_hold_end(p_sys->p_group_queue);
+            break;
+    }
+}
+
+static void join_group(intf_thread_t *p_intf, intf_sys_t *p_sys)
+{
+    char *psz_group = var_InheritString(p_intf, SYNC_GROUP_CFG);
+    if (!psz_group || !*psz_group) {
+        free(psz_group);
+        return;
+    }
+
+    p_sys->p_intf = p_intf;
+    p_sys->p_group_queue = worker_attach_queue(p_sys->p_worker);
+    if (!p_sys->p_group_queue
+     || group_join(VLC_OBJECT(p_intf), psz_group, group_callback, p_sys) != VLC_SUCCESS) {
+        msg_Warn(p_intf, "[Speed Hold] Playing without the sync group");
+        if (p_sys->p_group_queue)
+            worker_detach_queue(p_sys->p_group_queue);
+        p_sys->p_group_queue = NULL;
+    }
+    free(psz_group);
+}
+
+static void stop_capture(intf_sys_t *p_sys)
+{
+    filter_sys_t *p_state = p_sys->p_capture_sys;
+
+    capture_stop(p_sys->p_capture);
+
+    // The timer won't fire nor read the settings anymore once the hold is
+    // idle, so this thread can push on its queue
+    if (hold_release(&p_state->hold) == HOLD_RELEASE_RESTORE) {
+        worker_push_group(p_state->player.p_timer_queue, GROUP_CMD_RELEASE, p_state->original_rate, NULL);
+        worker_push_rate(p_state->player.p_timer_queue, p_state->original_rate);
+        worker_push_osd_text(p_state->player.p_timer_queue, "");
+        worker_push_hold_end(p_state->player.p_timer_queue);
+    }
+
+    settings_clean(&p_state->settings);
+    filter_state_release(&p_state->player);
 }
 
 static int OpenInterface(vlc_object_t *p_this)
 {
-    p_interface_thread = (intf_thread_t*) p_this;
+    intf_thread_t *p_intf = (intf_thread_t*) p_this;
 
     print_version(p_this);
-    msg_Dbg(p_interface_thread, "[Speed Hold] interface sub-plugin opened");
+
+    intf_sys_t *p_sys = calloc(1, sizeof(intf_sys_t));
+    if (!p_sys)
+        return VLC_ENOMEM;
+
+    p_sys->p_worker = worker_create(p_intf);
+    if (!p_sys->p_worker) {
+        msg_Err(p_intf, "[Speed Hold] Couldn't start the worker thread");
+        free(p_sys);
+        return VLC_EGENERIC;
+    }
+
+    if (registry_add_interface(p_intf, p_sys->p_worker) != VLC_SUCCESS) {
+        msg_Err(p_intf, "[Speed Hold] another interface sub-plugin is already running");
+        worker_destroy(p_sys->p_worker);
+        free(p_sys);
+        return VLC_EGENERIC;
+    }
+
+    // without it, the preferences only apply to the next media
+    p_sys->settings_watched = settings_watch_start(&p_sys->settings_watch, p_this) == VLC_SUCCESS;
+    if (!p_sys->settings_watched)
+        msg_Warn(p_intf, "[Speed Hold] Couldn't follow the preferences");
+
+    if (var_InheritBool(p_intf, MOUSE_CAPTURE_CFG) && start_capture(p_intf, p_sys) != VLC_SUCCESS) {
+        msg_Err(p_intf, "[Speed Hold] Couldn't capture the mouse from the video outputs");
+        if (p_sys->settings_watched)
+            settings_watch_stop(&p_sys->settings_watch);
+        registry_remove_interface(p_intf);
+        worker_destroy(p_sys->p_worker);
+        free(p_sys);
+        return VLC_EGENERIC;
+    }
+
+    // playing on without it only forgets the rates
+    if (var_InheritBool(p_intf, SPEED_MEMORY_CFG))
+        history_open(p_this);
+
+    join_group(p_intf, p_sys);
+
+    var_Create(p_intf, TRACE_DUMP_VAR, VLC_VAR_STRING | VLC_VAR_ISCOMMAND);
+    var_AddCallback(p_intf, TRACE_DUMP_VAR, trace_dump_callback, NULL);
+
+    p_intf->p_sys = p_sys;
+    msg_Dbg(p_intf, "[Speed Hold] interface sub-plugin opened");
 
     return VLC_SUCCESS;
 }
 
 static void CloseInterface(vlc_object_t *p_this)
 {
+    intf_thread_t *p_intf = (intf_thread_t*) p_this;
+    intf_sys_t *p_sys = p_intf->p_sys;
+
     msg_Dbg(p_this, "[Speed Hold] interface sub-plugin closed");
 
-    p_interface_thread = NULL;
+    var_DelCallback(p_intf, TRACE_DUMP_VAR, trace_dump_callback, NULL);
+    var_Destroy(p_intf, TRACE_DUMP_VAR);
+
+    if (p_sys->p_capture)
+        stop_capture(p_sys);
+
+    size_t filters = registry_remove_interface(p_intf);
+    if (filters > 0)
+        msg_Warn(p_this, "[Speed Hold] %zu filter(s) still open, their commands are dropped", filters);
+
+    speed_hold_worker_stats_t stats;
+    worker_get_stats(p_sys->p_worker, &stats);
+    msg_Dbg(p_this, "[Speed Hold] worker: %" PRIu64 " commands, %" PRIu64 " dropped, "
+            "queue depth %u (max %u), wait avg %" PRId64 " us, max %" PRId64 " us, "
+            "%" PRIu64 " ramp steps coalesced",
+            stats.commands, stats.dropped, stats.depth, stats.max_depth,
+            stats.commands ? (int64_t)(stats.total_wait / stats.commands) : 0,
+            (int64_t)stats.max_wait, stats.coalesced);
+    metrics_log(p_this);
+
+    // after the worker wrote the speed memory of the filters still open
+    worker_destroy(p_sys->p_worker);
+    history_close();
+
+    // left once the worker published the last commands, e.g. the release of
+    // stop_capture()
+    if (p_sys->p_group_queue) {
+        group_leave();
+        worker_detach_queue(p_sys->p_group_queue);
+    }
+    if (p_sys->settings_watched)
+        settings_watch_stop(&p_sys->settings_watch);
+    free(p_sys);
 }
 
 
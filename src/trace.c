@@ -0,0 +1,71 @@
+#include <vlc_common.h>
+#include <vlc_fs.h>
+
+#include <stdatomic.h>
+
+#include "compat.h"
+#include "trace.h"
+
+// Each slot is guarded by its own sequence number: 0 while it is written,
+// then the event index + 1. A reader keeps a slot only if the number is the
+// same before and after copying it.
+typedef struct
+{
+    atomic_uint_fast64_t seq;
+    trace_record_t record;
+} trace_slot_t;
+
+static trace_slot_t trace_ring[TRACE_SIZE];
+static atomic_uint_fast64_t trace_next;
+
+void trace_record(trace_event_t event, float value)
+{
+    uint_fast64_t index = atomic_fetch_add_explicit(&trace_next, 1, memory_order_relaxed);
+    trace_slot_t *p_slot = &trace_ring[index & (TRACE_SIZE - 1)];
+
+    atomic_store_explicit(&p_slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    p_slot->record.time = _vlc_tick_now();
+    p_slot->record.value = value;
+    p_slot->record.event = event;
+    atomic_store_explicit(&p_slot->seq, index + 1, memory_order_release);
+}
+
+bool trace_dump(const char *psz_path)
+{
+    trace_record_t *p_records = malloc(sizeof(trace_record_t) * TRACE_SIZE);
+    if (!p_records)
+        return false;
+
+    uint_fast64_t next = atomic_load_explicit(&trace_next, memory_order_relaxed);
+    uint_fast64_t first = next > TRACE_SIZE ? next - TRACE_SIZE : 0;
+    uint32_t count = 0;
+
+    for (uint_fast64_t index = first; index < next; index++) {
+        trace_slot_t *p_slot = &trace_ring[index & (TRACE_SIZE - 1)];
+
+        if (atomic_load_explicit(&p_slot->seq, memory_order_acquire) != index + 1)
+            continue;
+        p_records[count] = p_slot->record;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&p_slot->seq, memory_order_relaxed) == index + 1)
+            count++;
+    }
+
+    trace_header_t header = {
+        .magic = TRACE_MAGIC,
+        .version = TRACE_VERSION,
+        .count = count,
+        .clock_freq = CLOCK_FREQ,
+    };
+
+    FILE *p_file = vlc_fopen(psz_path, "wb");
+    bool ok = p_file
+           && fwrite(&header, sizeof(header), 1, p_file) == 1
+           && fwrite(p_records, sizeof(trace_record_t), count, p_file) == count;
+    if (p_file && fclose(p_file) != 0)
+        ok = false;
+
+    free(p_records);
+    return ok;
+}
@@ -0,0 +1,52 @@
+#ifndef VLC_SPEED_HOLD_TRACE_H
+#define VLC_SPEED_HOLD_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Process-wide ring of the last TRACE_SIZE timestamped events, cheap enough to
+// stay enabled all the time. Recording is lock-free from any thread, the
+// oldest events get overwritten. The dump format is shared with the
+// tools/speed_hold_trace decoder, so this header doesn't depend on libvlccore.
+
+#define TRACE_SIZE 4096 // must be a power of 2
+
+#define TRACE_MAGIC 0x52544853 // "SHTR"
+#define TRACE_VERSION 1
+
+typedef enum
+{
+    TRACE_PRESS,
+    TRACE_RELEASE,
+    TRACE_TIMER_FIRE,
+    TRACE_RATE_ISSUED, // value: rate
+    TRACE_RATE_DONE, // value: rate
+    TRACE_OSD,
+    TRACE_CLICK,
+    TRACE_PAUSE_PLAY,
+    TRACE_EVENT_COUNT,
+} trace_event_t;
+
+// Dump file: a header followed by the records in chronological order, both
+// in host byte order
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t clock_freq; // time units per second
+} trace_header_t;
+
+typedef struct
+{
+    int64_t time;
+    float value;
+    uint32_t event;
+} trace_record_t;
+
+void trace_record(trace_event_t event, float value);
+
+// Writes the events currently in the ring, returns false on I/O errors
+bool trace_dump(const char *psz_path);
+
+#endif // VLC_SPEED_HOLD_TRACE_H
@@ -0,0 +1,1226 @@
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_interface.h>
+#include <vlc_threads.h>
+
+#include <inttypes.h>
+#include <math.h>
+#include <time.h>
+
+#include "compat.h"
+#include "group.h"
+#include "history.h"
+#include "keyframes.h"
+#include "metrics.h"
+#include "osd.h"
+#include "playback.h"
+#include "ramp.h"
+#include "trace.h"
+#include "worker.h"
+
+#define WORKER_QUEUE_SIZE 64 // must be a power of 2
+#define WORKER_TEXT_SIZE 32
+
+// How long dropped pictures keep being counted after a rate transition ends
+#define WORKER_SETTLE_TIME (CLOCK_FREQ / 2)
+
+// How often the decoder statistics are sampled while a hold is governed
+#define WORKER_GOVERN_INTERVAL (CLOCK_FREQ / 2)
+#define WORKER_GOVERN_DOWN 0.75f
+#define WORKER_GOVERN_UP 1.25f
+
+#define WORKER_SKIM_INTERVAL (CLOCK_FREQ / 4)
+
+// Minimum time between two rate changes while dragging
+#define WORKER_DRAG_INTERVAL (CLOCK_FREQ / 10)
+
+// Media whose speed memory is kept until their filter closes, one per filter
+// open at once
+#define WORKER_MEMORY_SIZE 4
+
+// How often the input throughput is sampled during a hold
+#define WORKER_IO_INTERVAL CLOCK_FREQ
+
+// How often the effective speed is measured during a hold
+#define WORKER_SPEED_INTERVAL (CLOCK_FREQ / 2)
+// Share of the speed error corrected at each measurement
+#define WORKER_SPEED_GAIN 0.5f
+// The corrected rate stays within this factor of the hold rate
+#define WORKER_SPEED_MAX_CORRECTION 1.5f
+
+typedef enum
+{
+    WORKER_CMD_SET_RATE,
+    WORKER_CMD_RAMP_RATE,
+    WORKER_CMD_HOLD_RATE,
+    WORKER_CMD_SKIM,
+    WORKER_CMD_DRAG_RATE,
+    WORKER_CMD_PAUSE_PLAY,
+    WORKER_CMD_OSD_TEXT,
+    WORKER_CMD_AUDIO_BYPASS,
+    WORKER_CMD_HOLD_END,
+    WORKER_CMD_AUTO_RATE,
+    WORKER_CMD_GROUP,
+    WORKER_CMD_MEMORY,
+    WORKER_CMD_MEMORY_SAVE,
+} worker_cmd_type_t;
+
+typedef struct
+{
+    uint64_t seq;
+    _vlc_tick_t enqueued;
+    worker_cmd_type_t type;
+    float rate;
+    hold_params_t hold;
+    audio_bypass_t audio_bypass;
+    group_cmd_type_t group;
+    worker_auto_t auto_source;
+    uint64_t key;
+    history_entry_t memory;
+    char text[WORKER_TEXT_SIZE];
+} worker_cmd_t;
+
+typedef struct
+{
+    uint64_t key;
+    history_entry_t entry; // a base rate of 0 is the one of the player
+} worker_memory_t;
+
+struct speed_hold_queue_t
+{
+    speed_hold_worker_t *p_worker;
+    speed_hold_queue_t *p_next;
+    bool detached; // protected by p_worker->lock
+
+    atomic_uint head; // written by the worker only
+    atomic_uint tail; // written by the producer only
+    atomic_uint dropped;
+    worker_cmd_t cmds[WORKER_QUEUE_SIZE];
+};
+
+struct speed_hold_worker_t
+{
+    intf_thread_t *p_intf;
+    vlc_thread_t thread;
+    vlc_sem_t wakeup;
+    vlc_timer_t tick; // wakes the thread up while a ramp or measurement runs
+    atomic_bool quit;
+    atomic_uint refs;
+    atomic_uint auto_cancels;
+
+    // Commands are executed in global push order across all queues, so a rate
+    // restore pushed by mouse() can't overtake the acceleration pushed by the
+    // timer just before it.
+    atomic_uint_fast64_t next_seq;
+    uint64_t expected_seq;
+
+    vlc_mutex_t lock;
+    speed_hold_queue_t *p_queues;
+    bool running;
+
+    // protected by lock
+    uint64_t commands;
+    uint64_t dropped;
+    unsigned max_depth;
+    _vlc_tick_t total_wait;
+    _vlc_tick_t max_wait;
+    uint64_t coalesced;
+    float rate_ceiling;
+
+    // worker thread only
+    ramp_t ramp;
+    float last_rate;
+    bool measuring;
+    bool measure_ramped;
+    _vlc_tick_t measure_end;
+    picture_stats_t measure_stats;
+    bool governing;
+    bool govern_sampled;
+    float govern_base;
+    float govern_target;
+    hold_params_t govern_params;
+    _vlc_tick_t govern_next;
+    picture_stats_t govern_stats;
+    bool skimming;
+    float skim_rate;
+    _vlc_tick_t skim_start_date;
+    _vlc_tick_t skim_start_time;
+    _vlc_tick_t skim_next;
+    _vlc_tick_t skim_seek_date; // of the last seek, 0 before the first one
+    _vlc_tick_t skim_seek_target;
+    _vlc_tick_t skim_landing; // estimated, -1 if unknown
+    keyframes_t keyframes;
+    char *psz_keyframes_uri; // media they were learned on
+    bool drag_pending;
+    bool drag_display;
+    float drag_rate;
+    _vlc_tick_t drag_next;
+    bool holding;
+    _vlc_tick_t hold_start_date;
+    _vlc_tick_t hold_start_cpu;
+    audio_bypass_t hold_audio_bypass;
+    bool io_sampled;
+    io_stats_t io_stats;
+    _vlc_tick_t io_date;
+    _vlc_tick_t io_next;
+    io_stats_t io_hold_start;
+    _vlc_tick_t io_hold_date;
+    int64_t io_min_ahead; // ms, -1 until measured
+    bool speed_measuring;
+    bool speed_sampled;
+    bool speed_control;
+    bool speed_display;
+    float speed_target;
+    float speed_effective; // smoothed, 0 until measured
+    _vlc_tick_t speed_time;
+    _vlc_tick_t speed_date;
+    _vlc_tick_t speed_next;
+    audio_state_t audio;
+    decoder_state_t decoder;
+    osd_t osd;
+    float auto_rates[WORKER_AUTO_COUNT]; // 0 while the source is over
+    float auto_base; // rate from before the first source
+    worker_memory_t memory[WORKER_MEMORY_SIZE]; // oldest first
+    unsigned memory_count;
+};
+
+static void worker_release(speed_hold_worker_t *p_worker)
+{
+    if (atomic_fetch_sub(&p_worker->refs, 1) != 1)
+        return;
+
+    osd_clean(&p_worker->osd);
+    keyframes_clean(&p_worker->keyframes);
+    free(p_worker->psz_keyframes_uri);
+    _vlc_mutex_destroy(&p_worker->lock);
+    _vlc_sem_destroy(&p_worker->wakeup);
+    free(p_worker);
+}
+
+static void queue_free(speed_hold_queue_t *p_queue)
+{
+    speed_hold_worker_t *p_worker = p_queue->p_worker;
+
+    p_worker->dropped += atomic_load(&p_queue->dropped);
+    free(p_queue);
+    worker_release(p_worker);
+}
+
+float worker_get_rate_ceiling(speed_hold_worker_t *p_worker)
+{
+    vlc_mutex_lock(&p_worker->lock);
+    float rate_ceiling = p_worker->rate_ceiling;
+    vlc_mutex_unlock(&p_worker->lock);
+
+    return rate_ceiling;
+}
+
+void worker_reset_rate_ceiling(speed_hold_worker_t *p_worker)
+{
+    vlc_mutex_lock(&p_worker->lock);
+    p_worker->rate_ceiling = 0.f;
+    vlc_mutex_unlock(&p_worker->lock);
+}
+
+// CPU time used by the whole process, -1 if the platform can't tell
+static _vlc_tick_t worker_cpu_time(void)
+{
+#ifdef CLOCK_PROCESS_CPUTIME_ID
+    struct timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == 0)
+        return ts.tv_sec * CLOCK_FREQ + ts.tv_nsec / (1000000000 / CLOCK_FREQ);
+#endif
+    return -1;
+}
+
+static void worker_show_text(speed_hold_worker_t *p_worker, const char *text)
+{
+    osd_show(&p_worker->osd, p_worker->p_intf, text, _vlc_tick_now());
+}
+
+static void worker_tick(void *data)
+{
+    speed_hold_worker_t *p_worker = data;
+    vlc_sem_post(&p_worker->wakeup);
+}
+
+static void worker_arm_tick(speed_hold_worker_t *p_worker)
+{
+    _vlc_tick_t deadline = INT64_MAX;
+
+    if (p_worker->ramp.active) {
+        deadline = ramp_next_date(&p_worker->ramp);
+    } else {
+        if (p_worker->measuring && p_worker->measure_end < deadline)
+            deadline = p_worker->measure_end;
+        if (p_worker->governing && p_worker->govern_next < deadline)
+            deadline = p_worker->govern_next;
+        if (p_worker->skimming && p_worker->skim_next < deadline)
+            deadline = p_worker->skim_next;
+        if (p_worker->drag_pending && p_worker->drag_next < deadline)
+            deadline = p_worker->drag_next;
+        if (p_worker->holding && p_worker->io_next < deadline)
+            deadline = p_worker->io_next;
+        if (p_worker->speed_measuring && p_worker->speed_next < deadline)
+            deadline = p_worker->speed_next;
+    }
+    if (osd_next_date(&p_worker->osd) < deadline)
+        deadline = osd_next_date(&p_worker->osd);
+
+    if (deadline == INT64_MAX)
+        vlc_timer_schedule(p_worker->tick, false, 0, 0);
+    else
+        vlc_timer_schedule(p_worker->tick, true, deadline, 0);
+}
+
+// Counts the pictures dropped from the start of a rate transition until it
+// has settled, so that ramped and stepped transitions can be compared
+static void worker_measure_start(speed_hold_worker_t *p_worker, bool ramped)
+{
+    if (p_worker->measuring) {
+        p_worker->measure_ramped |= ramped;
+        return;
+    }
+
+    p_worker->measuring = GetPictureStats(p_worker->p_intf, &p_worker->measure_stats);
+    p_worker->measure_ramped = ramped;
+}
+
+static void worker_measure_poll(speed_hold_worker_t *p_worker, _vlc_tick_t now)
+{
+    if (!p_worker->measuring || p_worker->ramp.active || now < p_worker->measure_end)
+        return;
+
+    p_worker->measuring = false;
+
+    picture_stats_t stats;
+    if (!GetPictureStats(p_worker->p_intf, &stats))
+        return;
+
+    msg_Dbg(p_worker->p_intf, "[Speed Hold] %s rate transition: %" PRId64 " lost, "
+            "%" PRId64 " late of %" PRId64 " decoded pictures",
+            p_worker->measure_ramped ? "ramped" : "stepped",
+            stats.lost - p_worker->measure_stats.lost,
+            stats.late - p_worker->measure_stats.late,
+            stats.decoded - p_worker->measure_stats.decoded);
+}
+
+// Stops whatever is currently driving the rate
+static void worker_stop_rate_control(speed_hold_worker_t *p_worker)
+{
+    p_worker->ramp.active = false;
+    p_worker->governing = false;
+    p_worker->skimming = false;
+    p_worker->drag_pending = false;
+    p_worker->speed_measuring = false;
+}
+
+static void worker_set_rate(speed_hold_worker_t *p_worker, float rate)
+{
+    trace_record(TRACE_RATE_ISSUED, rate);
+    _vlc_tick_t start = _vlc_tick_now();
+    SetRate(p_worker->p_intf, rate);
+    metrics_record(METRIC_SET_RATE, _vlc_tick_now() - start);
+    trace_record(TRACE_RATE_DONE, rate);
+    p_worker->last_rate = rate;
+}
+
+static void worker_ramp_poll(speed_hold_worker_t *p_worker, _vlc_tick_t now)
+{
+    float rate;
+
+    if (!ramp_poll(&p_worker->ramp, now, &rate))
+        return;
+
+    // An intermediate step is skipped while the player hasn't applied the
+    // previous one yet, the final step always goes through
+    if (p_worker->ramp.active && fabsf(GetRate(p_worker->p_intf) - p_worker->last_rate) > 0.01f) {
+        vlc_mutex_lock(&p_worker->lock);
+        p_worker->coalesced++;
+        vlc_mutex_unlock(&p_worker->lock);
+        return;
+    }
+
+    worker_set_rate(p_worker, rate);
+    if (!p_worker->ramp.active)
+        p_worker->measure_end = now + WORKER_SETTLE_TIME;
+}
+
+static void worker_ramp_start(speed_hold_worker_t *p_worker, float rate, const ramp_params_t *p_params)
+{
+    _vlc_tick_t now = _vlc_tick_now();
+
+    // A ramp started while another one runs continues from where that one is
+    float from = p_worker->ramp.active ? p_worker->last_rate : GetRate(p_worker->p_intf);
+    p_worker->last_rate = from;
+    worker_stop_rate_control(p_worker);
+
+    worker_measure_start(p_worker, p_params->duration > 0);
+    ramp_start(&p_worker->ramp, from, rate, p_params, now);
+    worker_ramp_poll(p_worker, now);
+}
+
+// Measures how fast the media time actually advances for a hold rate
+static void worker_speed_start(speed_hold_worker_t *p_worker, float target, bool display_speed)
+{
+    p_worker->speed_measuring = true;
+    p_worker->speed_sampled = false;
+    p_worker->speed_target = target;
+    p_worker->speed_display = display_speed;
+    p_worker->speed_effective = 0.f;
+    p_worker->speed_next = _vlc_tick_now();
+}
+
+// Compares the media time progression with the clock once the rate is
+// reached. The requested rate is only a wish, the player may not keep up with
+// it, or audio resampling may make it run slightly off.
+static void worker_speed_poll(speed_hold_worker_t *p_worker, _vlc_tick_t now)
+{
+    if (!p_worker->speed_measuring || p_worker->ramp.active || now < p_worker->speed_next)
+        return;
+
+    p_worker->speed_next = now + WORKER_SPEED_INTERVAL;
+
+    _vlc_tick_t time = GetTime(p_worker->p_intf);
+    if (time < 0) {
+        p_worker->speed_sampled = false;
+        return;
+    }
+
+    _vlc_tick_t prev_time = p_worker->speed_time;
+    _vlc_tick_t prev_date = p_worker->speed_date;
+    bool sampled = p_worker->speed_sampled;
+    p_worker->speed_time = time;
+    p_worker->speed_date = now;
+    p_worker->speed_sampled = true;
+    if (!sampled || now <= prev_date)
+        return;
+
+    // paused or seeking, nothing to measure
+    float effective = (float)(time - prev_time) / (now - prev_date);
+    if (effective <= 0.f)
+        return;
+
+    p_worker->speed_effective = p_worker->speed_effective > 0.f
+                              ? (p_worker->speed_effective + effective) / 2 : effective;
+
+    float target = p_worker->speed_target;
+    if (p_worker->speed_control && !p_worker->governing) {
+        float rate = p_worker->last_rate * (1.f + WORKER_SPEED_GAIN * (target / p_worker->speed_effective - 1.f));
+        if (rate > target * WORKER_SPEED_MAX_CORRECTION)
+            rate = target * WORKER_SPEED_MAX_CORRECTION;
+        else if (rate < target / WORKER_SPEED_MAX_CORRECTION)
+            rate = target / WORKER_SPEED_MAX_CORRECTION;
+
+        if (fabsf(rate - p_worker->last_rate) > target * 0.01f) {
+            msg_Dbg(p_worker->p_intf, "[Speed Hold] effective speed %f for %f, rate %f -> %f",
+                    p_worker->speed_effective, target, p_worker->last_rate, rate);
+            worker_set_rate(p_worker, rate);
+        }
+    }
+
+    if (p_worker->speed_display) {
+        char requested[WORKER_TEXT_SIZE / 2], achieved[WORKER_TEXT_SIZE / 2], text[WORKER_TEXT_SIZE];
+        format_speed_text(requested, sizeof(requested), target);
+        format_speed_text(achieved, sizeof(achieved), p_worker->speed_effective);
+        snprintf(text, sizeof(text), "%s (%s)", requested, achieved);
+        worker_show_text(p_worker, text);
+    }
+}
+
+// Samples how fast the input is read and demuxed. What was read but not
+// demuxed yet is the read-ahead, in time at the current demux speed: if it
+// drains during a hold, reading is what limits the rate.
+static void worker_io_poll(speed_hold_worker_t *p_worker, _vlc_tick_t now)
+{
+    if (!p_worker->holding || now < p_worker->io_next)
+        return;
+
+    p_worker->io_next = now + WORKER_IO_INTERVAL;
+
+    io_stats_t stats;
+    if (!GetIOStats(p_worker->p_intf, &stats))
+        return;
+
+    io_stats_t prev = p_worker->io_stats;
+    _vlc_tick_t elapsed = now - p_worker->io_date;
+    bool sampled = p_worker->io_sampled;
+    p_worker->io_stats = stats;
+    p_worker->io_date = now;
+    p_worker->io_sampled = true;
+    if (!sampled) {
+        p_worker->io_hold_start = stats;
+        p_worker->io_hold_date = now;
+        return;
+    }
+    if (elapsed <= 0)
+        return;
+
+    int64_t read_rate = (stats.read - prev.read) * CLOCK_FREQ / elapsed;
+    int64_t demux_rate = (stats.demuxed - prev.demuxed) * CLOCK_FREQ / elapsed;
+    int64_t ahead = demux_rate > 0 ? (stats.read - stats.demuxed) * 1000 / demux_rate : -1;
+
+    var_SetInteger(p_worker->p_intf, WORKER_READ_RATE_VAR, read_rate / 1000);
+    var_SetInteger(p_worker->p_intf, WORKER_DEMUX_RATE_VAR, demux_rate / 1000);
+    var_SetInteger(p_worker->p_intf, WORKER_READ_AHEAD_VAR, ahead);
+
+    if (ahead >= 0 && (p_worker->io_min_ahead < 0 || ahead < p_worker->io_min_ahead))
+        p_worker->io_min_ahead = ahead;
+}
+
+static void worker_io_summary(speed_hold_worker_t *p_worker)
+{
+    _vlc_tick_t elapsed = p_worker->io_date - p_worker->io_hold_date;
+    if (!p_worker->io_sampled || elapsed <= 0)
+        return;
+
+    msg_Dbg(p_worker->p_intf, "[Speed Hold] hold input: %" PRId64 " kB/s read, %" PRId64 " kB/s demuxed, "
+            "read-ahead down to %" PRId64 " ms",
+            (p_worker->io_stats.read - p_worker->io_hold_start.read) * CLOCK_FREQ / elapsed / 1000,
+            (p_worker->io_stats.demuxed - p_worker->io_hold_start.demuxed) * CLOCK_FREQ / elapsed / 1000,
+            p_worker->io_min_ahead);
+}
+
+// The hold owns the rate until its release restores the one from before it
+static void worker_auto_cancel(speed_hold_worker_t *p_worker)
+{
+    bool active = false;
+    for (unsigned i = 0; i < WORKER_AUTO_COUNT; i++) {
+        active |= p_worker->auto_rates[i] > 0.f;
+        p_worker->auto_rates[i] = 0.f;
+    }
+    if (active)
+        atomic_fetch_add_explicit(&p_worker->auto_cancels, 1, memory_order_release);
+}
+
+// Keeps track of the CPU and I/O used during a hold
+static void worker_hold_begin(speed_hold_worker_t *p_worker)
+{
+    if (p_worker->holding)
+        return;
+
+    p_worker->holding = true;
+    worker_auto_cancel(p_worker);
+    p_worker->hold_start_date = _vlc_tick_now();
+    p_worker->hold_start_cpu = worker_cpu_time();
+    p_worker->hold_audio_bypass = AUDIO_BYPASS_NONE;
+    p_worker->io_sampled = false;
+    p_worker->io_next = p_worker->hold_start_date;
+    p_worker->io_min_ahead = -1;
+}
+
+static void worker_hold_end(speed_hold_worker_t *p_worker)
+{
+    RestoreAudio(p_worker->p_intf, &p_worker->audio);
+    SetFastDecoding(p_worker->p_intf, false, &p_worker->decoder);
+
+    if (!p_worker->holding)
+        return;
+    p_worker->holding = false;
+    worker_io_summary(p_worker);
+
+    _vlc_tick_t cpu = worker_cpu_time();
+    _vlc_tick_t duration = _vlc_tick_now() - p_worker->hold_start_date;
+    if (cpu < 0 || p_worker->hold_start_cpu < 0 || duration <= 0)
+        return;
+
+    static const char *const audio_texts[] = { "audio unchanged", "audio muted", "audio disabled" };
+    msg_Dbg(p_worker->p_intf, "[Speed Hold] hold of %.1f s used %.0f%% CPU (%s)",
+            duration / (double)CLOCK_FREQ, (cpu - p_worker->hold_start_cpu) * 100. / duration,
+            audio_texts[p_worker->hold_audio_bypass]);
+}
+
+static void worker_hold_start(speed_hold_worker_t *p_worker, float rate, const hold_params_t *p_params)
+{
+    worker_hold_begin(p_worker);
+    if (p_params->fast_decoding)
+        SetFastDecoding(p_worker->p_intf, true, &p_worker->decoder);
+
+    // Start at the rate the previous holds settled on, the governor raises it
+    // again if the machine keeps up
+    float rate_ceiling = p_params->max_drop_ratio > 0.f ? worker_get_rate_ceiling(p_worker) : 0.f;
+    worker_ramp_start(p_worker, rate_ceiling > 0.f && rate_ceiling < rate ? rate_ceiling : rate, &p_params->ramp);
+    // the ramp sets its first step right away
+    if (p_params->pressed > 0)
+        metrics_record(METRIC_PRESS_TO_RATE, _vlc_tick_now() - p_params->pressed);
+
+    worker_speed_start(p_worker, rate, p_params->display_speed);
+    p_worker->speed_control = p_params->speed_control;
+
+    if (p_params->max_drop_ratio > 0.f) {
+        p_worker->governing = true;
+        p_worker->govern_sampled = false;
+        p_worker->govern_base = p_worker->ramp.from;
+        p_worker->govern_target = rate;
+        p_worker->govern_params = *p_params;
+        p_worker->govern_next = _vlc_tick_now();
+    }
+}
+
+// Lowers the rate of a hold while the decoder can't keep up with it, and
+// raises it back towards the requested one once it does again
+static void worker_govern_poll(speed_hold_worker_t *p_worker, _vlc_tick_t now)
+{
+    if (!p_worker->governing || p_worker->ramp.active || now < p_worker->govern_next)
+        return;
+
+    _vlc_tick_t elapsed = now - p_worker->govern_next + WORKER_GOVERN_INTERVAL;
+    p_worker->govern_next = now + WORKER_GOVERN_INTERVAL;
+
+    picture_stats_t stats;
+    if (!GetPictureStats(p_worker->p_intf, &stats))
+        return;
+
+    picture_stats_t prev = p_worker->govern_stats;
+    bool sampled = p_worker->govern_sampled;
+    p_worker->govern_stats = stats;
+    p_worker->govern_sampled = true;
+    if (!sampled)
+        return;
+
+    int64_t decoded = stats.decoded - prev.decoded;
+    int64_t dropped = stats.lost - prev.lost + stats.late - prev.late;
+    if (decoded <= 0)
+        return;
+
+    float drop_ratio = (float)dropped / decoded;
+    float rate = p_worker->last_rate;
+    float max_drop_ratio = p_worker->govern_params.max_drop_ratio;
+
+    if (drop_ratio > max_drop_ratio) {
+        rate *= WORKER_GOVERN_DOWN;
+        if (rate < p_worker->govern_base)
+            rate = p_worker->govern_base;
+    } else if (drop_ratio < max_drop_ratio / 4 && rate < p_worker->govern_target) {
+        rate *= WORKER_GOVERN_UP;
+        if (rate > p_worker->govern_target)
+            rate = p_worker->govern_target;
+    }
+
+    if (rate == p_worker->last_rate)
+        return;
+
+    msg_Dbg(p_worker->p_intf, "[Speed Hold] %.1f%% pictures dropped at %.1f decoded fps, "
+            "rate %f -> %f", drop_ratio * 100, decoded * (double)CLOCK_FREQ / elapsed,
+            p_worker->last_rate, rate);
+
+    worker_set_rate(p_worker, rate);
+
+    vlc_mutex_lock(&p_worker->lock);
+    p_worker->rate_ceiling = rate < p_worker->govern_target ? rate : 0.f;
+    vlc_mutex_unlock(&p_worker->lock);
+
+    if (p_worker->govern_params.display_speed) {
+        char text[WORKER_TEXT_SIZE];
+        format_speed_text(text, sizeof(text), rate);
+        worker_show_text(p_worker, text);
+    }
+}
+
+static void worker_skim_start(speed_hold_worker_t *p_worker, float rate)
+{
+    _vlc_tick_t time = GetTime(p_worker->p_intf);
+    if (time < 0)
+        return;
+
+    char *psz_uri = GetMediaURI(p_worker->p_intf);
+    if (!psz_uri || !p_worker->psz_keyframes_uri || strcmp(psz_uri, p_worker->psz_keyframes_uri)) {
+        keyframes_reset(&p_worker->keyframes);
+        free(p_worker->psz_keyframes_uri);
+        p_worker->psz_keyframes_uri = psz_uri;
+    } else {
+        free(psz_uri);
+    }
+
+    worker_stop_rate_control(p_worker);
+    worker_hold_begin(p_worker);
+    p_worker->skimming = true;
+    p_worker->skim_rate = rate;
+    p_worker->skim_start_date = _vlc_tick_now();
+    p_worker->skim_start_time = time;
+    p_worker->skim_next = p_worker->skim_start_date + WORKER_SKIM_INTERVAL;
+    p_worker->skim_seek_date = 0;
+    p_worker->skim_landing = -1;
+}
+
+// A fast seek lands on the keyframe before its target, which is where the
+// time is now minus what was played since
+static void worker_skim_landed(speed_hold_worker_t *p_worker, _vlc_tick_t now)
+{
+    _vlc_tick_t time = GetTime(p_worker->p_intf);
+    if (time < 0)
+        return;
+
+    _vlc_tick_t landing = time - (_vlc_tick_t)((now - p_worker->skim_seek_date) * p_worker->last_rate);
+    if (landing > p_worker->skim_seek_target)
+        landing = p_worker->skim_seek_target;
+    keyframes_add(&p_worker->keyframes, landing);
+    p_worker->skim_landing = landing;
+}
+
+// Seeks to where the media would be at the skim rate. The target is derived
+// from the start of the skim rather than the current time, so slow seeks
+// don't make it drift behind. Backwards, each step goes to a keyframe before
+// the last landing, otherwise steps shorter than a GOP keep landing on the
+// same picture.
+static void worker_skim_poll(speed_hold_worker_t *p_worker, _vlc_tick_t now)
+{
+    if (!p_worker->skimming || now < p_worker->skim_next)
+        return;
+
+    if (p_worker->skim_seek_date > 0)
+        worker_skim_landed(p_worker, now);
+
+    p_worker->skim_next = now + WORKER_SKIM_INTERVAL;
+    _vlc_tick_t time = p_worker->skim_start_time
+                     + (_vlc_tick_t)((now - p_worker->skim_start_date) * p_worker->skim_rate);
+
+    if (p_worker->skim_rate < 0.f) {
+        if (time < 0)
+            time = 0;
+        if (p_worker->skim_landing > 0 && time >= p_worker->skim_landing)
+            time = p_worker->skim_landing - 1;
+
+        // a known keyframe within the step is sought exactly
+        _vlc_tick_t keyframe = keyframes_find(&p_worker->keyframes, time);
+        _vlc_tick_t step = (_vlc_tick_t)(WORKER_SKIM_INTERVAL * -p_worker->skim_rate);
+        if (keyframe >= 0 && time - keyframe < step
+         && (p_worker->skim_landing < 0 || keyframe + KEYFRAMES_TOLERANCE < p_worker->skim_landing))
+            time = keyframe + KEYFRAMES_TOLERANCE;
+    }
+
+    p_worker->skim_seek_date = now;
+    p_worker->skim_seek_target = time;
+    SeekTo(p_worker->p_intf, time, true);
+}
+
+static void worker_drag_start(speed_hold_worker_t *p_worker, float rate, bool display_speed)
+{
+    if (!p_worker->drag_pending)
+        worker_stop_rate_control(p_worker);
+
+    p_worker->drag_pending = true;
+    p_worker->drag_rate = rate;
+    p_worker->drag_display = display_speed;
+}
+
+// Applies the latest dragged rate, at most once per WORKER_DRAG_INTERVAL.
+// Rates dragged in between replace each other without reaching the player.
+static void worker_drag_poll(speed_hold_worker_t *p_worker, _vlc_tick_t now)
+{
+    if (!p_worker->drag_pending || now < p_worker->drag_next)
+        return;
+
+    p_worker->drag_pending = false;
+    p_worker->drag_next = now + WORKER_DRAG_INTERVAL;
+    worker_set_rate(p_worker, p_worker->drag_rate);
+    if (p_worker->holding)
+        worker_speed_start(p_worker, p_worker->drag_rate, p_worker->drag_display);
+
+    if (p_worker->drag_display) {
+        char text[WORKER_TEXT_SIZE];
+        format_speed_text(text, sizeof(text), p_worker->drag_rate);
+        worker_show_text(p_worker, text);
+    }
+}
+
+static void worker_auto_rate(speed_hold_worker_t *p_worker, const worker_cmd_t *p_cmd)
+{
+    // the user holding the button takes precedence over the content
+    if (p_worker->holding) {
+        if (p_cmd->rate > 0.f)
+            atomic_fetch_add_explicit(&p_worker->auto_cancels, 1, memory_order_release);
+        return;
+    }
+
+    float old_rate = 0.f;
+    for (unsigned i = 0; i < WORKER_AUTO_COUNT; i++)
+        old_rate = fmaxf(old_rate, p_worker->auto_rates[i]);
+    if (old_rate == 0.f) {
+        // a source ending without having started, e.g. after a hold
+        if (p_cmd->rate == 0.f)
+            return;
+        p_worker->auto_base = p_worker->ramp.active ? p_worker->ramp.to : GetRate(p_worker->p_intf);
+    }
+
+    p_worker->auto_rates[p_cmd->auto_source] = p_cmd->rate;
+    float rate = 0.f;
+    for (unsigned i = 0; i < WORKER_AUTO_COUNT; i++)
+        rate = fmaxf(rate, p_worker->auto_rates[i]);
+    if (rate == old_rate)
+        return;
+
+    if (rate == 0.f) {
+        worker_ramp_start(p_worker, p_worker->auto_base, &p_cmd->hold.ramp);
+        if (p_cmd->hold.display_speed)
+            worker_show_text(p_worker, p_cmd->text);
+    } else {
+        // the other source may be the one going on
+        worker_ramp_start(p_worker, rate, &p_cmd->hold.ramp);
+        if (p_cmd->hold.display_speed) {
+            char text[WORKER_TEXT_SIZE];
+            format_speed_text(text, sizeof(text), rate);
+            worker_show_text(p_worker, text);
+        }
+    }
+}
+
+// A single write per media played, to the mapped pages only
+static void worker_memory_store(speed_hold_worker_t *p_worker, unsigned index)
+{
+    worker_memory_t *p_memory = &p_worker->memory[index];
+    // a restore still ramping counts as done
+    if (p_memory->entry.base_rate <= 0.f)
+        p_memory->entry.base_rate = p_worker->ramp.active ? p_worker->ramp.to : GetRate(p_worker->p_intf);
+    history_store(p_memory->key, &p_memory->entry);
+
+    p_worker->memory_count--;
+    memmove(p_memory, p_memory + 1, (p_worker->memory_count - index) * sizeof(*p_memory));
+}
+
+static void worker_memory_update(speed_hold_worker_t *p_worker, uint64_t key, const history_entry_t *p_entry)
+{
+    unsigned index = 0;
+    while (index < p_worker->memory_count && p_worker->memory[index].key != key)
+        index++;
+
+    if (index == p_worker->memory_count) {
+        // more filters than expected, the oldest media is written early
+        if (p_worker->memory_count == WORKER_MEMORY_SIZE) {
+            worker_memory_store(p_worker, 0);
+            index--;
+        }
+        p_worker->memory[index] = (worker_memory_t) { .key = key };
+        p_worker->memory_count++;
+    }
+
+    if (p_entry->base_rate >= 0.f)
+        p_worker->memory[index].entry.base_rate = p_entry->base_rate;
+    if (p_entry->hold_rate >= 0.f)
+        p_worker->memory[index].entry.hold_rate = p_entry->hold_rate;
+}
+
+static void worker_memory_save(speed_hold_worker_t *p_worker, uint64_t key)
+{
+    for (unsigned i = 0; i < p_worker->memory_count; i++) {
+        if (p_worker->memory[i].key == key) {
+            worker_memory_store(p_worker, i);
+            return;
+        }
+    }
+}
+
+static void worker_execute(speed_hold_worker_t *p_worker, const worker_cmd_t *p_cmd)
+{
+    switch (p_cmd->type) {
+        case WORKER_CMD_SET_RATE:
+            worker_stop_rate_control(p_worker);
+            worker_set_rate(p_worker, p_cmd->rate);
+            break;
+        case WORKER_CMD_RAMP_RATE:
+            worker_ramp_start(p_worker, p_cmd->rate, &p_cmd->hold.ramp);
+            break;
+        case WORKER_CMD_HOLD_RATE:
+            worker_hold_start(p_worker, p_cmd->rate, &p_cmd->hold);
+            break;
+        case WORKER_CMD_SKIM:
+            worker_skim_start(p_worker, p_cmd->rate);
+            break;
+        case WORKER_CMD_GROUP:
+            group_publish(p_cmd->group, p_cmd->rate, &p_cmd->hold.ramp);
+            break;
+        case WORKER_CMD_DRAG_RATE:
+            worker_drag_start(p_worker, p_cmd->rate, p_cmd->hold.display_speed);
+            break;
+        case WORKER_CMD_PAUSE_PLAY:
+            PausePlay(p_worker->p_intf);
+            trace_record(TRACE_PAUSE_PLAY, 0.f);
+            // pushed on the release of the click
+            metrics_record(METRIC_CLICK_TO_PAUSE, _vlc_tick_now() - p_cmd->enqueued);
+            break;
+        case WORKER_CMD_OSD_TEXT:
+            worker_show_text(p_worker, p_cmd->text);
+            break;
+        case WORKER_CMD_AUDIO_BYPASS:
+            if (p_worker->audio.bypass == AUDIO_BYPASS_NONE)
+                BypassAudio(p_worker->p_intf, p_cmd->audio_bypass, &p_worker->audio);
+            if (p_worker->holding && p_worker->audio.bypass != AUDIO_BYPASS_NONE)
+                p_worker->hold_audio_bypass = p_worker->audio.bypass;
+            break;
+        case WORKER_CMD_HOLD_END:
+            worker_hold_end(p_worker);
+            break;
+        case WORKER_CMD_AUTO_RATE:
+            worker_auto_rate(p_worker, p_cmd);
+            break;
+        case WORKER_CMD_MEMORY:
+            worker_memory_update(p_worker, p_cmd->key, &p_cmd->memory);
+            break;
+        case WORKER_CMD_MEMORY_SAVE:
+            worker_memory_save(p_worker, p_cmd->key);
+            break;
+    }
+}
+
+// Pops the command with the expected sequence number. Returns false if it is
+// not published yet, in which case its producer is about to post the wakeup.
+static bool worker_pop(speed_hold_worker_t *p_worker, worker_cmd_t *p_cmd)
+{
+    bool found = false;
+
+    vlc_mutex_lock(&p_worker->lock);
+    speed_hold_queue_t **pp_queue = &p_worker->p_queues;
+    while (*pp_queue) {
+        speed_hold_queue_t *p_queue = *pp_queue;
+        unsigned head = atomic_load_explicit(&p_queue->head, memory_order_relaxed);
+        unsigned tail = atomic_load_explicit(&p_queue->tail, memory_order_acquire);
+
+        if (head == tail) {
+            if (p_queue->detached) {
+                *pp_queue = p_queue->p_next;
+                queue_free(p_queue);
+                continue;
+            }
+        } else if (!found && p_queue->cmds[head & (WORKER_QUEUE_SIZE - 1)].seq == p_worker->expected_seq) {
+            *p_cmd = p_queue->cmds[head & (WORKER_QUEUE_SIZE - 1)];
+            atomic_store_explicit(&p_queue->head, head + 1, memory_order_release);
+            p_worker->expected_seq++;
+            found = true;
+
+            unsigned depth = tail - head;
+            if (depth > p_worker->max_depth)
+                p_worker->max_depth = depth;
+        }
+        pp_queue = &p_queue->p_next;
+    }
+    vlc_mutex_unlock(&p_worker->lock);
+
+    return found;
+}
+
+static void worker_drain(speed_hold_worker_t *p_worker)
+{
+    worker_cmd_t cmd;
+
+    while (worker_pop(p_worker, &cmd)) {
+        _vlc_tick_t wait = _vlc_tick_now() - cmd.enqueued;
+        metrics_record(METRIC_QUEUE_WAIT, wait);
+
+        vlc_mutex_lock(&p_worker->lock);
+        p_worker->commands++;
+        p_worker->total_wait += wait;
+        if (wait > p_worker->max_wait)
+            p_worker->max_wait = wait;
+        vlc_mutex_unlock(&p_worker->lock);
+
+        worker_execute(p_worker, &cmd);
+    }
+}
+
+static void *worker_thread(void *data)
+{
+    speed_hold_worker_t *p_worker = data;
+
+    while (!atomic_load(&p_worker->quit)) {
+        vlc_sem_wait(&p_worker->wakeup);
+        worker_drain(p_worker);
+        metrics_publish(VLC_OBJECT(p_worker->p_intf));
+
+        _vlc_tick_t now = _vlc_tick_now();
+        worker_ramp_poll(p_worker, now);
+        worker_measure_poll(p_worker, now);
+        worker_govern_poll(p_worker, now);
+        worker_skim_poll(p_worker, now);
+        worker_drag_poll(p_worker, now);
+        worker_io_poll(p_worker, now);
+        worker_speed_poll(p_worker, now);
+        osd_poll(&p_worker->osd, p_worker->p_intf, now);
+        worker_arm_tick(p_worker);
+    }
+
+    // The restores pushed while quitting, e.g. by stop_capture() or a filter
+    // closing meanwhile, are still applied. A ramp they start has no tick to
+    // step it anymore, so it ends at once.
+    worker_drain(p_worker);
+    if (p_worker->ramp.active)
+        worker_set_rate(p_worker, p_worker->ramp.to);
+
+    // the filters still open can't reach the player or the table anymore
+    while (p_worker->memory_count > 0)
+        worker_memory_store(p_worker, 0);
+
+    msg_Dbg(p_worker->p_intf, "[Speed Hold] OSD: %" PRIu64 " texts sent, %" PRIu64 " skipped",
+            p_worker->osd.sent, p_worker->osd.skipped);
+
+    // the player outlives the interface, don't leave it muted or degraded
+    RestoreAudio(p_worker->p_intf, &p_worker->audio);
+    SetFastDecoding(p_worker->p_intf, false, &p_worker->decoder);
+
+    return NULL;
+}
+
+speed_hold_worker_t *worker_create(intf_thread_t *p_intf_thread)
+{
+    speed_hold_worker_t *p_worker = calloc(1, sizeof(speed_hold_worker_t));
+    if (!p_worker)
+        return NULL;
+
+    p_worker->p_intf = p_intf_thread;
+    vlc_sem_init(&p_worker->wakeup, 0);
+    vlc_mutex_init(&p_worker->lock);
+    osd_init(&p_worker->osd);
+    keyframes_init(&p_worker->keyframes);
+    atomic_init(&p_worker->quit, false);
+    atomic_init(&p_worker->refs, 1);
+    atomic_init(&p_worker->auto_cancels, 0);
+    atomic_init(&p_worker->next_seq, 0);
+
+    if (vlc_timer_create(&p_worker->tick, worker_tick, p_worker) != VLC_SUCCESS) {
+        worker_release(p_worker);
+        return NULL;
+    }
+
+    var_Create(p_intf_thread, WORKER_READ_RATE_VAR, VLC_VAR_INTEGER);
+    var_Create(p_intf_thread, WORKER_DEMUX_RATE_VAR, VLC_VAR_INTEGER);
+    var_Create(p_intf_thread, WORKER_READ_AHEAD_VAR, VLC_VAR_INTEGER);
+    metrics_create_vars(VLC_OBJECT(p_intf_thread));
+
+    if (_vlc_clone(&p_worker->thread, worker_thread, p_worker) != VLC_SUCCESS) {
+        var_Destroy(p_intf_thread, WORKER_READ_RATE_VAR);
+        var_Destroy(p_intf_thread, WORKER_DEMUX_RATE_VAR);
+        var_Destroy(p_intf_thread, WORKER_READ_AHEAD_VAR);
+        metrics_destroy_vars(VLC_OBJECT(p_intf_thread));
+        vlc_timer_destroy(p_worker->tick);
+        worker_release(p_worker);
+        return NULL;
+    }
+    p_worker->running = true;
+
+    return p_worker;
+}
+
+void worker_destroy(speed_hold_worker_t *p_worker)
+{
+    atomic_store(&p_worker->quit, true);
+    vlc_sem_post(&p_worker->wakeup);
+    vlc_join(p_worker->thread, NULL);
+    // the thread re-arms the timer until it returns
+    vlc_timer_destroy(p_worker->tick);
+
+    var_Destroy(p_worker->p_intf, WORKER_READ_RATE_VAR);
+    var_Destroy(p_worker->p_intf, WORKER_DEMUX_RATE_VAR);
+    var_Destroy(p_worker->p_intf, WORKER_READ_AHEAD_VAR);
+    metrics_destroy_vars(VLC_OBJECT(p_worker->p_intf));
+
+    // Queues still attached belong to filters that outlive the interface,
+    // they keep the worker allocated until they are detached
+    vlc_mutex_lock(&p_worker->lock);
+    p_worker->running = false;
+    speed_hold_queue_t **pp_queue = &p_worker->p_queues;
+    while (*pp_queue) {
+        speed_hold_queue_t *p_queue = *pp_queue;
+        if (p_queue->detached) {
+            *pp_queue = p_queue->p_next;
+            queue_free(p_queue);
+        } else {
+            pp_queue = &p_queue->p_next;
+        }
+    }
+    vlc_mutex_unlock(&p_worker->lock);
+
+    worker_release(p_worker);
+}
+
+void worker_get_stats(speed_hold_worker_t *p_worker, speed_hold_worker_stats_t *p_stats)
+{
+    vlc_mutex_lock(&p_worker->lock);
+    p_stats->commands = p_worker->commands;
+    p_stats->dropped = p_worker->dropped;
+    p_stats->depth = 0;
+    p_stats->max_depth = p_worker->max_depth;
+    p_stats->total_wait = p_worker->total_wait;
+    p_stats->max_wait = p_worker->max_wait;
+    p_stats->coalesced = p_worker->coalesced;
+    for (speed_hold_queue_t *p_queue = p_worker->p_queues; p_queue; p_queue = p_queue->p_next) {
+        p_stats->depth += atomic_load(&p_queue->tail) - atomic_load(&p_queue->head);
+        p_stats->dropped += atomic_load(&p_queue->dropped);
+    }
+    vlc_mutex_unlock(&p_worker->lock);
+}
+
+void worker_attach_osd(speed_hold_worker_t *p_worker, vlc_object_t *p_filter)
+{
+    osd_attach_vout(&p_worker->osd, p_filter);
+}
+
+void worker_detach_osd(speed_hold_worker_t *p_worker, vlc_object_t *p_filter)
+{
+    osd_detach_vout(&p_worker->osd, p_filter);
+}
+
+void worker_osd_vouts_changed(speed_hold_worker_t *p_worker)
+{
+    osd_vouts_changed(&p_worker->osd);
+}
+
+speed_hold_queue_t *worker_attach_queue(speed_hold_worker_t *p_worker)
+{
+    speed_hold_queue_t *p_queue = calloc(1, sizeof(speed_hold_queue_t));
+    if (!p_queue)
+        return NULL;
+
+    p_queue->p_worker = p_worker;
+    atomic_init(&p_queue->head, 0);
+    atomic_init(&p_queue->tail, 0);
+    atomic_init(&p_queue->dropped, 0);
+    atomic_fetch_add(&p_worker->refs, 1);
+
+    vlc_mutex_lock(&p_worker->lock);
+    p_queue->p_next = p_worker->p_queues;
+    p_worker->p_queues = p_queue;
+    vlc_mutex_unlock(&p_worker->lock);
+
+    return p_queue;
+}
+
+void worker_detach_queue(speed_hold_queue_t *p_queue)
+{
+    speed_hold_worker_t *p_worker = p_queue->p_worker;
+
+    vlc_mutex_lock(&p_worker->lock);
+    if (p_worker->running) {
+        // the worker frees it once the remaining commands are executed
+        p_queue->detached = true;
+        vlc_mutex_unlock(&p_worker->lock);
+        vlc_sem_post(&p_worker->wakeup);
+        return;
+    }
+
+    speed_hold_queue_t **pp_queue = &p_worker->p_queues;
+    while (*pp_queue != p_queue)
+        pp_queue = &(*pp_queue)->p_next;
+    *pp_queue = p_queue->p_next;
+    vlc_mutex_unlock(&p_worker->lock);
+
+    // the worker might be freed along with its last queue, so this has to
+    // happen outside of its lock
+    free(p_queue);
+    worker_release(p_worker);
+}
+
+static bool worker_push(speed_hold_queue_t *p_queue, worker_cmd_t *p_cmd)
+{
+    speed_hold_worker_t *p_worker = p_queue->p_worker;
+    unsigned tail = atomic_load_explicit(&p_queue->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&p_queue->head, memory_order_acquire);
+
+    if (tail - head == WORKER_QUEUE_SIZE) {
+        atomic_fetch_add_explicit(&p_queue->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    // The sequence number is taken only once the slot is known to be free, a
+    // number that is never published would stall the worker
+    p_cmd->seq = atomic_fetch_add_explicit(&p_worker->next_seq, 1, memory_order_relaxed);
+    p_cmd->enqueued = _vlc_tick_now();
+    p_queue->cmds[tail & (WORKER_QUEUE_SIZE - 1)] = *p_cmd;
+    atomic_store_explicit(&p_queue->tail, tail + 1, memory_order_release);
+    vlc_sem_post(&p_worker->wakeup);
+
+    return true;
+}
+
+bool worker_push_rate(speed_hold_queue_t *p_queue, float rate)
+{
+    worker_cmd_t cmd = { .type = WORKER_CMD_SET_RATE, .rate = rate };
+    return worker_push(p_queue, &cmd);
+}
+
+bool worker_push_ramp(speed_hold_queue_t *p_queue, float rate, const ramp_params_t *p_params)
+{
+    worker_cmd_t cmd = { .type = WORKER_CMD_RAMP_RATE, .rate = rate, .hold.ramp = *p_params };
+    return worker_push(p_queue, &cmd);
+}
+
+bool worker_push_hold(speed_hold_queue_t *p_queue, float rate, const hold_params_t *p_params)
+{
+    worker_cmd_t cmd = { .type = WORKER_CMD_HOLD_RATE, .rate = rate, .hold = *p_params };
+    return worker_push(p_queue, &cmd);
+}
+
+bool worker_push_skim(speed_hold_queue_t *p_queue, float rate)
+{
+    worker_cmd_t cmd = { .type = WORKER_CMD_SKIM, .rate = rate };
+    return worker_push(p_queue, &cmd);
+}
+
+bool worker_push_drag(speed_hold_queue_t *p_queue, float rate, bool display_speed)
+{
+    worker_cmd_t cmd = { .type = WORKER_CMD_DRAG_RATE, .rate = rate, .hold.display_speed = display_speed };
+    return worker_push(p_queue, &cmd);
+}
+
+bool worker_push_pause_play(speed_hold_queue_t *p_queue)
+{
+    worker_cmd_t cmd = { .type = WORKER_CMD_PAUSE_PLAY };
+    return worker_push(p_queue, &cmd);
+}
+
+bool worker_push_osd_text(speed_hold_queue_t *p_queue, const char *text)
+{
+    worker_cmd_t cmd = { .type = WORKER_CMD_OSD_TEXT };
+    strncpy(cmd.text, text, sizeof(cmd.text) - 1);
+    return worker_push(p_queue, &cmd);
+}
+
+bool worker_push_audio_bypass(speed_hold_queue_t *p_queue, audio_bypass_t bypass)
+{
+    worker_cmd_t cmd = { .type = WORKER_CMD_AUDIO_BYPASS, .audio_bypass = bypass };
+    return worker_push(p_queue, &cmd);
+}
+
+bool worker_push_hold_end(speed_hold_queue_t *p_queue)
+{
+    worker_cmd_t cmd = { .type = WORKER_CMD_HOLD_END };
+    return worker_push(p_queue, &cmd);
+}
+
+unsigned worker_get_auto_cancels(speed_hold_worker_t *p_worker)
+{
+    return atomic_load_explicit(&p_worker->auto_cancels, memory_order_acquire);
+}
+
+bool worker_push_auto_rate(speed_hold_queue_t *p_queue, worker_auto_t source, float rate,
+                           const ramp_params_t *p_params, const char *text)
+{
+    worker_cmd_t cmd = { .type = WORKER_CMD_AUTO_RATE, .auto_source = source, .rate = rate,
+                         .hold.ramp = *p_params, .hold.display_speed = text != NULL };
+    if (text)
+        strncpy(cmd.text, text, sizeof(cmd.text) - 1);
+    return worker_push(p_queue, &cmd);
+}
+
+bool worker_push_memory(speed_hold_queue_t *p_queue, uint64_t key, float base_rate, float hold_rate)
+{
+    worker_cmd_t cmd = { .type = WORKER_CMD_MEMORY, .key = key,
+                         .memory = { .base_rate = base_rate, .hold_rate = hold_rate } };
+    return worker_push(p_queue, &cmd);
+}
+
+bool worker_push_memory_save(speed_hold_queue_t *p_queue, uint64_t key)
+{
+    worker_cmd_t cmd = { .type = WORKER_CMD_MEMORY_SAVE, .key = key };
+    return worker_push(p_queue, &cmd);
+}
+
+bool worker_push_group(speed_hold_queue_t *p_queue, group_cmd_type_t type, float rate,
+                       const ramp_params_t *p_params)
+{
+    if (!group_is_joined())
+        return true;
+
+    worker_cmd_t cmd = { .type = WORKER_CMD_GROUP, .group = type, .rate = rate };
+    if (p_params)
+        cmd.hold.ramp = *p_params;
+    return worker_push(p_queue, &cmd);
+}
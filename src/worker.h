@@ -0,0 +1,124 @@
+#ifndef VLC_SPEED_HOLD_WORKER_H
+#define VLC_SPEED_HOLD_WORKER_H
+
+#include <vlc_common.h>
+#include <vlc_interface.h>
+
+#include "compat.h"
+#include "group.h"
+#include "playback.h"
+#include "ramp.h"
+
+// Thread that owns every player and OSD side effect. Producers (the vout
+// thread in mouse(), the hold timer) only ever touch their own lock-free
+// single-producer/single-consumer queue, so they never wait on the player lock.
+typedef struct speed_hold_worker_t speed_hold_worker_t;
+
+// Integer variables of the interface updated during holds, to tell whether
+// reading or decoding limits the rate
+#define WORKER_READ_RATE_VAR "speed-hold-read-rate" // kB/s read by the access
+#define WORKER_DEMUX_RATE_VAR "speed-hold-demux-rate" // kB/s consumed by the demuxer
+#define WORKER_READ_AHEAD_VAR "speed-hold-read-ahead" // ms of data read but not demuxed yet
+typedef struct speed_hold_queue_t speed_hold_queue_t;
+
+typedef struct
+{
+    uint64_t commands;
+    uint64_t dropped;
+    unsigned depth;
+    unsigned max_depth;
+    _vlc_tick_t total_wait;
+    _vlc_tick_t max_wait;
+    uint64_t coalesced; // ramp steps skipped while the player was busy
+} speed_hold_worker_stats_t;
+
+speed_hold_worker_t *worker_create(intf_thread_t *p_intf_thread);
+void worker_destroy(speed_hold_worker_t *p_worker);
+void worker_get_stats(speed_hold_worker_t *p_worker, speed_hold_worker_stats_t *p_stats);
+
+// Highest rate the last holds could sustain, 0 if none of them had to be
+// lowered. It applies to the content being played, reset it when that changes.
+float worker_get_rate_ceiling(speed_hold_worker_t *p_worker);
+void worker_reset_rate_ceiling(speed_hold_worker_t *p_worker);
+
+// The OSD texts go to the video output of the last attached video filter
+void worker_attach_osd(speed_hold_worker_t *p_worker, vlc_object_t *p_filter);
+void worker_detach_osd(speed_hold_worker_t *p_worker, vlc_object_t *p_filter);
+// Without a filter they go to every video output of the player, which has to
+// be told when those change. Only takes a lock of the OSD.
+void worker_osd_vouts_changed(speed_hold_worker_t *p_worker);
+
+// A queue must only be pushed to by one thread at a time. Commands still
+// queued when it is detached are executed before it is freed.
+speed_hold_queue_t *worker_attach_queue(speed_hold_worker_t *p_worker);
+void worker_detach_queue(speed_hold_queue_t *p_queue);
+
+typedef struct
+{
+    ramp_params_t ramp;
+    // Lower the rate while more than this ratio of the decoded pictures gets
+    // dropped or displayed late, 0 disables it
+    float max_drop_ratio;
+    bool display_speed;
+    // Decode without the deblocking filter and non-reference frames until the
+    // end of the hold
+    bool fast_decoding;
+    // Correct the requested rate so that the media time advances at the hold
+    // rate, unless max_drop_ratio already drives it
+    bool speed_control;
+    // Date of the press that led to the hold, 0 if unknown
+    _vlc_tick_t pressed;
+} hold_params_t;
+
+bool worker_push_rate(speed_hold_queue_t *p_queue, float rate);
+bool worker_push_ramp(speed_hold_queue_t *p_queue, float rate, const ramp_params_t *p_params);
+// Ramps to the acceleration rate and keeps it within what the machine can
+// sustain until the next rate command
+bool worker_push_hold(speed_hold_queue_t *p_queue, float rate, const hold_params_t *p_params);
+// Advances the media time at the given rate with periodic keyframe seeks
+// instead of decoding every frame, until the next rate command
+// A negative rate skims backwards
+bool worker_push_skim(speed_hold_queue_t *p_queue, float rate);
+// Rate picked by dragging during a hold. The worker rate-limits these and
+// only applies the latest one.
+bool worker_push_drag(speed_hold_queue_t *p_queue, float rate, bool display_speed);
+bool worker_push_pause_play(speed_hold_queue_t *p_queue);
+bool worker_push_osd_text(speed_hold_queue_t *p_queue, const char *text);
+// Mutes or disables the audio until the end of the hold, unless something
+// else already did
+bool worker_push_audio_bypass(speed_hold_queue_t *p_queue, audio_bypass_t bypass);
+// Gives back the audio and logs how much CPU the hold used
+bool worker_push_hold_end(speed_hold_queue_t *p_queue);
+// Sources of the rates picked from the content being played
+typedef enum
+{
+    WORKER_AUTO_MOTION, // auto speed of the video filter
+    WORKER_AUTO_SILENCE, // silence skipping of the audio filter
+    WORKER_AUTO_COUNT,
+} worker_auto_t;
+
+// Rate picked by a source from the content being played, 0 once it's over.
+// The highest rate of the sources applies, and the rate from before the
+// first one is restored after the last one. A hold cancels them all, and a
+// rate pushed while it runs is ignored. The text, unless NULL, is displayed
+// if the rate is applied.
+bool worker_push_auto_rate(speed_hold_queue_t *p_queue, worker_auto_t source, float rate,
+                           const ramp_params_t *p_params, const char *text);
+// Counts the rates the worker cancelled or ignored for a hold, a source whose
+// rate applied since sees it change
+unsigned worker_get_auto_cancels(speed_hold_worker_t *p_worker);
+// What to remember of a media, the speed memory of which is owned by the
+// worker so that it is read and written from a single thread. A negative rate
+// keeps the one pushed before for the media, a base rate of 0 stands for the
+// rate of the player when saving.
+bool worker_push_memory(speed_hold_queue_t *p_queue, uint64_t key, float base_rate, float hold_rate);
+// Writes the speed memory of the media once its filter closes. What wasn't
+// saved yet is written when the worker quits.
+bool worker_push_memory_save(speed_hold_queue_t *p_queue, uint64_t key);
+// Publishes to the sync group from the worker thread, so that the producers
+// don't wait on the group lock or the shared memory. Pushes nothing unless a
+// group was joined. The ramp can be NULL.
+bool worker_push_group(speed_hold_queue_t *p_queue, group_cmd_type_t type, float rate,
+                       const ramp_params_t *p_params);
+
+#endif // VLC_SPEED_HOLD_WORKER_H
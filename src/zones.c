@@ -0,0 +1,200 @@
+#include <vlc_common.h>
+#include <vlc_charset.h>
+
+#include <math.h>
+
+#include "zones.h"
+
+static const char *skip_spaces(const char *p)
+{
+    while (*p == ' ')
+        p++;
+    return p;
+}
+
+static const char *parse_range(const char *p, float *p_start, float *p_end)
+{
+    char *end;
+
+    p = skip_spaces(p);
+    if (*p == '*') {
+        *p_start = 0.f;
+        *p_end = 1.f;
+        return p + 1;
+    }
+
+    *p_start = us_strtof(p, &end) / 100.f;
+    if (end == p || *end != '-')
+        return NULL;
+    p = end + 1;
+
+    *p_end = us_strtof(p, &end) / 100.f;
+    if (end == p || *end != '%')
+        return NULL;
+
+    if (*p_start < 0.f || *p_end > 1.f || *p_start >= *p_end)
+        return NULL;
+
+    return end + 1;
+}
+
+int zone_map_parse(zone_map_t *p_map, const char *psz_zones)
+{
+    const char *p = skip_spaces(psz_zones);
+
+    p_map->count = 0;
+    while (*p) {
+        if (p_map->count == ZONES_MAX)
+            return VLC_EGENERIC;
+
+        zone_t *p_zone = &p_map->zones[p_map->count];
+        p = parse_range(p, &p_zone->x0, &p_zone->x1);
+        if (!p)
+            return VLC_EGENERIC;
+
+        if (*p == '/') {
+            p = parse_range(p + 1, &p_zone->y0, &p_zone->y1);
+            if (!p)
+                return VLC_EGENERIC;
+        } else {
+            p_zone->y0 = 0.f;
+            p_zone->y1 = 1.f;
+        }
+
+        if (*p != ':')
+            return VLC_EGENERIC;
+        p++;
+
+        char *end;
+        p_zone->rate = us_strtof(p, &end);
+        if (end == p || p_zone->rate <= 0.f)
+            return VLC_EGENERIC;
+        p = end;
+        if (*p == 'x')
+            p++;
+        p = skip_spaces(p);
+
+        if (*p == ',')
+            p = skip_spaces(p + 1);
+        else if (*p)
+            return VLC_EGENERIC;
+
+        p_map->count++;
+    }
+
+    return VLC_SUCCESS;
+}
+
+void zone_map_edges(zone_map_t *p_map, float edge_rate)
+{
+    p_map->zones[0] = (zone_t) { 0.f, 0.2f, 0.f, 1.f, edge_rate };
+    p_map->zones[1] = (zone_t) { 0.8f, 1.f, 0.f, 1.f, edge_rate };
+    p_map->count = 2;
+}
+
+// First pixel whose centre lies at or after the fraction
+static unsigned border_pixel(float fraction, unsigned size)
+{
+    float pixel = ceilf(fraction * size - 0.5f);
+    return pixel < 0.f ? 0 : pixel;
+}
+
+static int compare_borders(const void *a, const void *b)
+{
+    unsigned x = *(const unsigned *)a;
+    unsigned y = *(const unsigned *)b;
+    return (x > y) - (x < y);
+}
+
+// Splits [0, size) at every zone border and maps each pixel to its band.
+// Returns the number of bands and the first pixel of each in p_starts.
+static unsigned build_bands(uint8_t *p_bands, unsigned *p_starts, unsigned size,
+                            const zone_map_t *p_map, bool vertical)
+{
+    unsigned borders[2 * ZONES_MAX + 1];
+    unsigned count = 0;
+
+    borders[count++] = 0;
+    for (unsigned i = 0; i < p_map->count; i++) {
+        const zone_t *p_zone = &p_map->zones[i];
+        borders[count++] = border_pixel(vertical ? p_zone->y0 : p_zone->x0, size);
+        borders[count++] = border_pixel(vertical ? p_zone->y1 : p_zone->x1, size);
+    }
+    qsort(borders, count, sizeof(*borders), compare_borders);
+
+    unsigned bands = 0;
+    for (unsigned i = 0; i < count; i++) {
+        if (borders[i] >= size || (bands > 0 && borders[i] == p_starts[bands - 1]))
+            continue;
+        p_starts[bands++] = borders[i];
+    }
+
+    unsigned band = 0;
+    for (unsigned i = 0; i < size; i++) {
+        if (band + 1 < bands && i >= p_starts[band + 1])
+            band++;
+        p_bands[i] = band;
+    }
+
+    return bands;
+}
+
+int zone_lut_build(zone_lut_t *p_lut, const zone_map_t *p_map, unsigned width, unsigned height)
+{
+    zone_lut_clean(p_lut);
+    if (width == 0 || height == 0)
+        return VLC_EGENERIC;
+
+    unsigned column_starts[2 * ZONES_MAX + 1];
+    unsigned row_starts[2 * ZONES_MAX + 1];
+
+    p_lut->p_columns = malloc(width);
+    p_lut->p_rows = malloc(height);
+    if (!p_lut->p_columns || !p_lut->p_rows) {
+        zone_lut_clean(p_lut);
+        return VLC_ENOMEM;
+    }
+
+    unsigned column_bands = build_bands(p_lut->p_columns, column_starts, width, p_map, false);
+    unsigned row_bands = build_bands(p_lut->p_rows, row_starts, height, p_map, true);
+
+    p_lut->p_rates = calloc(column_bands * row_bands, sizeof(float));
+    if (!p_lut->p_rates) {
+        zone_lut_clean(p_lut);
+        return VLC_ENOMEM;
+    }
+
+    // A band is entirely inside or outside of every zone, so testing the
+    // centre of its first pixel is enough
+    for (unsigned c = 0; c < column_bands; c++) {
+        float x = (column_starts[c] + 0.5f) / width;
+        for (unsigned r = 0; r < row_bands; r++) {
+            float y = (row_starts[r] + 0.5f) / height;
+            for (unsigned i = 0; i < p_map->count; i++) {
+                const zone_t *p_zone = &p_map->zones[i];
+                if (p_zone->x0 <= x && x < p_zone->x1 && p_zone->y0 <= y && y < p_zone->y1) {
+                    p_lut->p_rates[c * row_bands + r] = p_zone->rate;
+                    break;
+                }
+            }
+        }
+    }
+
+    p_lut->width = width;
+    p_lut->height = height;
+    p_lut->row_bands = row_bands;
+
+    return VLC_SUCCESS;
+}
+
+void zone_lut_clean(zone_lut_t *p_lut)
+{
+    free(p_lut->p_columns);
+    free(p_lut->p_rows);
+    free(p_lut->p_rates);
+    p_lut->p_columns = NULL;
+    p_lut->p_rows = NULL;
+    p_lut->p_rates = NULL;
+    p_lut->width = 0;
+    p_lut->height = 0;
+}
@@ -0,0 +1,61 @@
+#ifndef VLC_SPEED_HOLD_ZONES_H
+#define VLC_SPEED_HOLD_ZONES_H
+
+#include <vlc_common.h>
+
+#define ZONES_MAX 16
+
+// Area of the video, in fractions of its size, with the rate to use when the
+// press lands in it
+typedef struct
+{
+    float x0, x1;
+    float y0, y1;
+    float rate;
+} zone_t;
+
+// Earlier zones take precedence over later ones where they overlap
+typedef struct
+{
+    zone_t zones[ZONES_MAX];
+    unsigned count;
+} zone_map_t;
+
+// Parses a comma separated list of "<x range>[/<y range>]:<rate>[x]" zones,
+// a range being either "<start>-<end>%" or "*" for the whole axis,
+// e.g. "0-10%:8x,10-30%:3x,*/0-20%:2x"
+int zone_map_parse(zone_map_t *p_map, const char *psz_zones);
+
+// The map used when no zones are configured: the first and last 20% of the
+// width play at the edge rate
+void zone_map_edges(zone_map_t *p_map, float edge_rate);
+
+// Zone map compiled for a video size. Every pixel column and row is mapped to
+// a band between two zone borders, so looking up a rate is two loads and an
+// index, whatever the number of zones.
+typedef struct
+{
+    unsigned width;
+    unsigned height;
+    uint8_t *p_columns;
+    uint8_t *p_rows;
+    unsigned row_bands;
+    float *p_rates; // column band * row_bands + row band, 0 outside the zones
+} zone_lut_t;
+
+int zone_lut_build(zone_lut_t *p_lut, const zone_map_t *p_map, unsigned width, unsigned height);
+void zone_lut_clean(zone_lut_t *p_lut);
+
+// Returns 0 if the position isn't in any zone
+static inline float zone_lut_rate(const zone_lut_t *p_lut, int x, int y)
+{
+    if (!p_lut->p_rates)
+        return 0.f;
+
+    unsigned column = x < 0 ? 0 : (unsigned)x >= p_lut->width ? p_lut->width - 1 : (unsigned)x;
+    unsigned row = y < 0 ? 0 : (unsigned)y >= p_lut->height ? p_lut->height - 1 : (unsigned)y;
+
+    return p_lut->p_rates[p_lut->p_columns[column] * p_lut->row_bands + p_lut->p_rows[row]];
+}
+
+#endif // VLC_SPEED_HOLD_ZONES_H
@@ -0,0 +1,164 @@
+/*****************************************************************************
+ * speed_hold_trace.c : Prints the event traces dumped by the Speed Hold plugin
+ *****************************************************************************
+ * Copyright (C) 2025 supSugam
+ *
+ * Authors: supSugam
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *****************************************************************************/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/trace.h"
+
+#define HISTOGRAM_BUCKETS 24 // powers of 2 microseconds, up to ~8 s
+
+static const char *const event_names[TRACE_EVENT_COUNT] =
+{
+    [TRACE_PRESS] = "press",
+    [TRACE_RELEASE] = "release",
+    [TRACE_TIMER_FIRE] = "timer fire",
+    [TRACE_RATE_ISSUED] = "rate issued",
+    [TRACE_RATE_DONE] = "rate done",
+    [TRACE_OSD] = "osd",
+    [TRACE_CLICK] = "click",
+    [TRACE_PAUSE_PLAY] = "pause/play",
+};
+
+// Latency from an event to the next occurrence of another one, unless the
+// cancel event comes first
+static const struct
+{
+    const char *name;
+    trace_event_t from;
+    trace_event_t to;
+    int cancel; // -1 for none
+} latencies[] =
+{
+    { "press -> timer fire", TRACE_PRESS, TRACE_TIMER_FIRE, TRACE_RELEASE },
+    { "timer fire -> rate issued", TRACE_TIMER_FIRE, TRACE_RATE_ISSUED, TRACE_RELEASE },
+    { "rate issued -> rate done", TRACE_RATE_ISSUED, TRACE_RATE_DONE, -1 },
+    { "release -> rate issued", TRACE_RELEASE, TRACE_RATE_ISSUED, TRACE_PRESS },
+    { "click -> pause/play", TRACE_CLICK, TRACE_PAUSE_PLAY, -1 },
+};
+
+static int compare_records(const void *a, const void *b)
+{
+    const trace_record_t *x = a;
+    const trace_record_t *y = b;
+    return (x->time > y->time) - (x->time < y->time);
+}
+
+static const char *event_name(uint32_t event)
+{
+    return event < TRACE_EVENT_COUNT ? event_names[event] : "unknown";
+}
+
+static void print_timeline(const trace_record_t *p_records, uint32_t count, double unit)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        double time = (p_records[i].time - p_records[0].time) * unit;
+        printf("%12.3f ms  %-12s", time, event_name(p_records[i].event));
+        if (p_records[i].event == TRACE_RATE_ISSUED || p_records[i].event == TRACE_RATE_DONE)
+            printf(" %.2fx", p_records[i].value);
+        printf("\n");
+    }
+}
+
+static void print_histogram(const trace_record_t *p_records, uint32_t count, double unit, size_t l)
+{
+    unsigned buckets[HISTOGRAM_BUCKETS] = { 0 };
+    unsigned samples = 0;
+    double total = 0., max = 0.;
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (p_records[i].event != latencies[l].from)
+            continue;
+
+        for (uint32_t j = i + 1; j < count; j++) {
+            if ((int)p_records[j].event == latencies[l].cancel)
+                break;
+            if (p_records[j].event != latencies[l].to)
+                continue;
+
+            double us = (p_records[j].time - p_records[i].time) * unit * 1000.;
+            unsigned bucket = 0;
+            while (bucket + 1 < HISTOGRAM_BUCKETS && us >= (double)(1u << (bucket + 1)))
+                bucket++;
+            buckets[bucket]++;
+            samples++;
+            total += us;
+            if (us > max)
+                max = us;
+            break;
+        }
+    }
+
+    printf("\n%s: %u samples", latencies[l].name, samples);
+    if (samples == 0) {
+        printf("\n");
+        return;
+    }
+    printf(", avg %.0f us, max %.0f us\n", total / samples, max);
+
+    unsigned peak = 0;
+    for (unsigned b = 0; b < HISTOGRAM_BUCKETS; b++)
+        if (buckets[b] > peak)
+            peak = buckets[b];
+
+    for (unsigned b = 0; b < HISTOGRAM_BUCKETS; b++) {
+        if (buckets[b] == 0)
+            continue;
+        printf("  < %9u us %6u ", 1u << (b + 1), buckets[b]);
+        for (unsigned n = 0; n < buckets[b] * 40 / peak; n++)
+            putchar('#');
+        putchar('\n');
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <trace file>\n", argv[0]);
+        return 2;
+    }
+
+    FILE *p_file = fopen(argv[1], "rb");
+    if (!p_file) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    trace_header_t header;
+    if (fread(&header, sizeof(header), 1, p_file) != 1 || header.magic != TRACE_MAGIC
+     || header.version != TRACE_VERSION || header.clock_freq == 0) {
+        fprintf(stderr, "%s: not a Speed Hold trace, or from another version\n", argv[1]);
+        fclose(p_file);
+        return 1;
+    }
+
+    trace_record_t *p_records = malloc(sizeof(trace_record_t) * (header.count ? header.count : 1));
+    if (!p_records || fread(p_records, sizeof(trace_record_t), header.count, p_file) != header.count) {
+        fprintf(stderr, "%s: truncated trace\n", argv[1]);
+        free(p_records);
+        fclose(p_file);
+        return 1;
+    }
+    fclose(p_file);
+
+    // events are claimed in order but stamped right after, so neighbours
+    // from different threads can be swapped
+    qsort(p_records, header.count, sizeof(trace_record_t), compare_records);
+
+    double unit = 1000. / header.clock_freq; // ms
+    print_timeline(p_records, header.count, unit);
+    for (size_t l = 0; l < sizeof(latencies) / sizeof(latencies[0]); l++)
+        print_histogram(p_records, header.count, unit, l);
+
+    free(p_records);
+    return 0;
+}